@@ -11,9 +11,6 @@
 #define PIT_PORT_CONTROL          0x43                /* Control port. */
 #define PIT_PORT_COUNTER(CHANNEL) (0x40 + (CHANNEL))  /* Counter port. */
 
-/* PIT cycles per second. */
-#define PIT_HZ 1193180
-
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
    three output channels are hooked up like this:
 
@@ -81,3 +78,60 @@ pit_configure_channel (int channel, int mode, int frequency)
   outb (PIT_PORT_COUNTER (channel), count >> 8);
   intr_set_level (old_level);
 }
+
+/* CHANNEL을 mode 0 (interrupt on terminal count)으로 설정한다.
+   COUNT PIT cycle이 지나면 channel의 출력이 1이 되면서 interrupt가
+   한 번만 발생하고, 다시 설정하기 전까지는 interrupt가 발생하지 않는다.
+   tickless idle에서 다음에 깨어날 시간까지 timer interrupt를 
+   미루는 데 사용한다. COUNT가 0이면 65536으로 취급된다. */
+void
+pit_configure_oneshot (int channel, uint16_t count)
+{
+  enum intr_level old_level;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30 | (0 << 1));
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* CHANNEL의 현재 counter 값을 latch해서 읽어온다. */
+uint16_t
+pit_read_counter (int channel)
+{
+  enum intr_level old_level;
+  uint16_t count;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, channel << 6);        /* Counter latch command. */
+  count = inb (PIT_PORT_COUNTER (channel));
+  count |= inb (PIT_PORT_COUNTER (channel)) << 8;
+  intr_set_level (old_level);
+
+  return count;
+}
+
+/* CHANNEL의 출력이 1인지 read-back 명령으로 확인한다.
+   mode 0에서는 counter가 0에 도달한 뒤 출력이 1이 되므로,
+   one-shot timer가 이미 만료되었는지 알 수 있다. */
+bool
+pit_output_high (int channel)
+{
+  enum intr_level old_level;
+  uint8_t status;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  /* Read-back command: latch status only, for CHANNEL. */
+  outb (PIT_PORT_CONTROL, 0xc0 | 0x20 | (1 << (channel + 1)));
+  status = inb (PIT_PORT_COUNTER (channel));
+  intr_set_level (old_level);
+
+  return (status & 0x80) != 0;
+}
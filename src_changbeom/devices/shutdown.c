@@ -4,8 +4,12 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
@@ -94,6 +98,10 @@ shutdown_power_off (void)
   filesys_done ();
 #endif
 
+  /* panic으로 interrupt handler 안에서 종료하는 경우에는 출력하지 않는다. */
+  if (trace_dump_on_shutdown && !intr_context ())
+    trace_dump ();
+
   print_stats ();
 
   printf ("Powering off...\n");
@@ -120,6 +128,15 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  thread_print_stack_stats ();
+  palloc_print_stats ();
+  kmem_print_stats ();
+#ifdef INTR_TRACE
+  intr_print_stats ();
+#endif
+#ifdef LOCK_STAT
+  lock_stat_print ();
+#endif
 #ifdef FILESYS
   block_print_stats ();
 #endif
@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include <kernel/heap.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
@@ -20,6 +21,55 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* If true, the idle thread stops the periodic timer interrupt
+   until the next sleeping thread must wake up.
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+/* timer tick 하나에 해당하는 PIT cycle 수. */
+#define PIT_PER_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* one-shot 모드로 한 번에 미룰 수 있는 최대 tick 수.
+   PIT counter가 16비트이므로 100 Hz 기준으로 5 tick까지 가능하다. */
+#define ONESHOT_MAX_TICKS (UINT16_MAX / PIT_PER_TICK)
+
+/* tickless idle을 위해 PIT를 one-shot 모드로 설정해 두었는지 여부와
+   그 때의 설정값들. interrupt가 꺼진 상태에서만 접근한다. */
+static bool oneshot_armed;
+static uint16_t oneshot_count;  /* one-shot으로 설정한 PIT cycle 수. */
+static unsigned oneshot_phase;  /* 설정할 때 현재 tick에서 이미 지난 PIT cycle 수. */
+static int64_t oneshot_ticks;   /* one-shot이 만료되면 지나가는 tick 수. */
+
+/* Number of nanoseconds per second. */
+#define NSEC_PER_SEC 1000000000LL
+
+/* TSC 주파수를 측정하는 데 사용할 tick 수. */
+#define TSC_CALIBRATE_TICKS 10
+
+/* 남은 시간이 이보다 짧으면 block하지 않고 TSC로 busy-wait한다.
+   이보다 짧은 sleep은 context switch와 interrupt 처리 비용에 묻힌다. */
+#define HRSLEEP_MIN_NS 20000
+
+/* one-shot interrupt가 deadline보다 이만큼 이내로 일찍 와도 깨운다.
+   PIT와 TSC 사이의 오차를 흡수하기 위한 값으로, PIT cycle 하나 정도이다. */
+#define HRSLEEP_SLACK_NS 1000
+
+/* 초당 TSC cycle 수. timer_calibrate()가 PIT tick에 맞춰 측정하며,
+   측정 전에는 0이어서 timer_ns()가 ticks로 계산한다. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;       /* 측정을 마친 순간의 TSC 값. */
+static int64_t tsc_base_ns;     /* 그 순간의 timer_ns() 값. */
+
+/* timer_msleep(), timer_usleep(), timer_nsleep()으로 잠든 스레드들의
+   heap. wakeup_ns가 가장 이른 스레드가 top이다.
+   interrupt가 꺼진 상태에서만 접근한다. */
+static struct heap hrsleep_heap;
+
+/* timer interrupt 하나를 처리하는 데 걸린 시간 통계. TSC cycle 단위이다. */
+static uint64_t irq_max_cycles;
+static uint64_t irq_total_cycles;
+static uint64_t irq_cnt;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -29,6 +79,13 @@ static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 static void real_time_delay (int64_t num, int32_t denom);
+static bool cmp_wakeup_ns (const struct heap_elem *, const struct heap_elem *,
+                           void *aux);
+static uint32_t hrsleep_cycles (void);
+static void hrsleep_wake (void);
+static void hrsleep_arm (void);
+static void oneshot_arm (unsigned phase, uint32_t count);
+static void oneshot_arm_next (unsigned phase);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
@@ -36,14 +93,18 @@ void
 timer_init (void) 
 {
   pit_configure_channel (0, 2, TIMER_FREQ);
+  heap_init (&hrsleep_heap, cmp_wakeup_ns, NULL);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays,
+   and the TSC frequency, used by timer_ns(). */
 void
 timer_calibrate (void) 
 {
   unsigned high_bit, test_bit;
+  int64_t start;
+  uint64_t tsc_start, tsc_end;
 
   ASSERT (intr_get_level () == INTR_ON);
   printf ("Calibrating timer...  ");
@@ -63,7 +124,24 @@ timer_calibrate (void)
     if (!too_many_loops (high_bit | test_bit))
       loops_per_tick |= test_bit;
 
-  printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+  /* tick 경계에서 시작해서 TSC_CALIBRATE_TICKS tick 동안
+     TSC가 얼마나 증가하는지 재서 TSC 주파수를 구한다. */
+  start = ticks;
+  while (ticks == start)
+    barrier ();
+  start = ticks;
+  tsc_start = timer_tsc ();
+  while (ticks - start < TSC_CALIBRATE_TICKS)
+    barrier ();
+  tsc_end = timer_tsc ();
+
+  tsc_base = tsc_end;
+  tsc_base_ns = ticks * (NSEC_PER_SEC / TIMER_FREQ);
+  barrier ();
+  tsc_hz = (tsc_end - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+
+  printf ("%'"PRIu64" loops/s, %'"PRIu64" TSC cycles/s.\n",
+          (uint64_t) loops_per_tick * TIMER_FREQ, tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -84,6 +162,24 @@ timer_elapsed (int64_t then)
   return timer_ticks () - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted.
+   timer_calibrate() 이후에는 TSC를 읽어서 tick보다 훨씬 정밀하며,
+   interrupt가 꺼져 있어도 사용할 수 있다. */
+int64_t
+timer_ns (void)
+{
+  uint64_t d;
+
+  if (tsc_hz == 0)
+    return timer_ticks () * (NSEC_PER_SEC / TIMER_FREQ);
+
+  /* d * NSEC_PER_SEC는 몇 초만 지나도 64비트를 넘기 때문에
+     초 단위와 그 나머지로 나눠서 변환한다. */
+  d = timer_tsc () - tsc_base;
+  return tsc_base_ns + d / tsc_hz * NSEC_PER_SEC
+         + d % tsc_hz * NSEC_PER_SEC / tsc_hz;
+}
+
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void
@@ -101,6 +197,51 @@ timer_sleep (int64_t ticks)
   
 }
 
+/* Returns the number of TSC cycles per second, or 0 if
+   timer_calibrate() has not measured it yet. */
+uint64_t
+timer_tsc_hz (void)
+{
+  return tsc_hz;
+}
+
+/* Sleeps until timer_ns() reaches DEADLINE.  Interrupts must be
+   turned on.
+   tick 경계를 기다리지 않고 deadline에 PIT one-shot interrupt를 받아서
+   깨어난다. 남은 시간이 HRSLEEP_MIN_NS보다 짧으면 busy-wait한다. */
+void
+timer_sleep_until_ns (int64_t deadline)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (intr_get_level () == INTR_ON);
+
+  if (tsc_hz == 0)
+    {
+      /* TSC를 측정하기 전에는 tick 단위로 올림해서 잠든다. */
+      int64_t tick_ns = NSEC_PER_SEC / TIMER_FREQ;
+      thread_sleep ((deadline + tick_ns - 1) / tick_ns);
+      return;
+    }
+
+  old_level = intr_disable ();
+  if (deadline - timer_ns () < HRSLEEP_MIN_NS)
+    {
+      intr_set_level (old_level);
+      while (timer_ns () < deadline)
+        barrier ();
+      return;
+    }
+
+  cur->wakeup_ns = deadline;
+  heap_push (&hrsleep_heap, &cur->sleep_elem);
+  hrsleep_arm ();
+  cur->block_kind = BLOCK_SLEEP;
+  thread_block ();
+  intr_set_level (old_level);
+}
+
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
    turned on. */
 void
@@ -171,19 +312,266 @@ timer_print_stats (void)
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
+/* idle thread가 hlt로 CPU를 쉬기 직전에 호출된다.
+   tickless 모드라면 다음으로 깨어날 스레드의 wakeup_tick까지
+   주기적인 timer interrupt를 멈추고, PIT를 그 tick 경계에서
+   한 번만 interrupt가 발생하는 one-shot 모드로 설정한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+void
+timer_idle_enter (void)
+{
+  int64_t delta;
+  unsigned phase;
+  uint32_t hr;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot_armed)
+    return;
+
+  /* 주기 모드의 counter는 PIT_PER_TICK부터 줄어들기 때문에,
+     현재 tick 안에서 이미 지난 cycle만큼 빼서 tick 경계에 맞춘다. */
+  phase = PIT_PER_TICK - pit_read_counter (0);
+  if (phase >= PIT_PER_TICK)
+    phase = 0;
+
+  /* 바로 다음 tick에 깨워야 할 스레드가 있으면 주기 모드를 유지한다.
+     hrsleep_heap의 deadline은 그 deadline이 속한 tick의 시작 경계까지만
+     미루고, 그 뒤로는 hrsleep_arm()이 설정하는 one-shot이 깨운다. */
+  delta = get_next_tick_to_awake () - ticks;
+  hr = hrsleep_cycles ();
+  if (hr != UINT32_MAX && (phase + hr) / PIT_PER_TICK < delta)
+    delta = (phase + hr) / PIT_PER_TICK;
+  if (delta < 2)
+    return;
+  if (delta > ONESHOT_MAX_TICKS)
+    delta = ONESHOT_MAX_TICKS;
+
+  oneshot_arm (phase, delta * PIT_PER_TICK - phase);
+}
+
+/* idle thread에서 다른 스레드로 전환될 때 호출된다.
+   one-shot이 아직 만료되지 않았다면 그동안 지난 tick만큼 ticks를
+   보정하고, 다음 tick 경계에서 한 번 더 interrupt를 받도록 해서
+   timer_interrupt()가 주기 모드로 되돌리게 한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+void
+timer_idle_exit (void)
+{
+  unsigned elapsed;
+  int64_t k;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* 이미 만료되었다면 대기 중인 timer interrupt가 처리한다.
+     현재 tick 안에서 끝나는 one-shot은 그대로 두면 된다. */
+  if (!oneshot_armed || oneshot_ticks <= 1 || pit_output_high (0))
+    return;
+
+  elapsed = oneshot_count - pit_read_counter (0) + oneshot_phase;
+  k = elapsed / PIT_PER_TICK;
+
+  thread_tick_idle (ticks, ticks + k);
+  ticks += k;
+
+  oneshot_arm_next (elapsed % PIT_PER_TICK);
+}
+
+/* timer interrupt 처리 시간의 최대값과 평균값을 MAX_CYCLES, AVG_CYCLES에 저장한다. */
+void
+timer_irq_stats (uint64_t *max_cycles, uint64_t *avg_cycles)
+{
+  enum intr_level old_level = intr_disable ();
+  *max_cycles = irq_max_cycles;
+  *avg_cycles = irq_cnt > 0 ? irq_total_cycles / irq_cnt : 0;
+  intr_set_level (old_level);
+}
+
+/* timer interrupt 처리 시간 통계를 초기화한다. */
+void
+timer_irq_stats_reset (void)
+{
+  enum intr_level old_level = intr_disable ();
+  irq_max_cycles = irq_total_cycles = irq_cnt = 0;
+  intr_set_level (old_level);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
-  ticks++;
-  thread_tick ();
-
-  /* 매 틱마다 sleep queue에서 깨어날 thread가 있는지 확인하여, 
-     깨우는 함수를 호출하도록 한다. */
-  if (ticks >= get_next_tick_to_awake ())  {
-    thread_awake (ticks); 
-  }
-  
+  uint64_t start = timer_tsc ();
+  uint64_t cycles;
+
+  /* tick 중간에 끝나도록 설정한 one-shot이 만료되었다면 아직 tick은
+     지나지 않았으므로, hrsleep_heap의 스레드만 깨우고 다음 deadline이나
+     tick 경계에서 interrupt가 오도록 다시 설정한다. */
+  if (oneshot_armed && oneshot_ticks == 0 && pit_output_high (0))
+    {
+      oneshot_armed = false;
+      hrsleep_wake ();
+      oneshot_arm_next (oneshot_phase + oneshot_count);
+    }
+  else
+    {
+      /* tick 경계의 one-shot이 만료되었으면 주기 모드로 되돌리고,
+         interrupt 없이 지나간 tick들을 한꺼번에 반영한다.
+         출력이 아직 0이라면 one-shot 설정 직전에 걸려있던 주기 interrupt이므로
+         보통의 tick으로 처리한다. */
+      if (oneshot_armed && pit_output_high (0))
+        {
+          oneshot_armed = false;
+          pit_configure_channel (0, 2, TIMER_FREQ);
+          thread_tick_idle (ticks, ticks + oneshot_ticks - 1);
+          ticks += oneshot_ticks - 1;
+        }
+
+      ticks++;
+      thread_tick ();
+
+      /* 매 틱마다 sleep queue에서 깨어날 thread가 있는지 확인하여, 
+         깨우는 함수를 호출하도록 한다. */
+      if (ticks >= get_next_tick_to_awake ())  {
+        thread_awake (ticks); 
+      }
+
+      /* 이번 tick 안에 deadline이 있는 hrsleep 스레드를 위해
+         one-shot을 설정한다. */
+      hrsleep_wake ();
+      hrsleep_arm ();
+    }
+
+  /* interrupt 처리 시간 통계를 갱신한다. */
+  cycles = timer_tsc () - start;
+  if (cycles > irq_max_cycles)
+    irq_max_cycles = cycles;
+  irq_total_cycles += cycles;
+  irq_cnt++;
+}
+
+/* hrsleep_heap에서 wakeup_ns가 더 이른 thread가 앞에 오도록 비교하는 함수이다. */
+static bool
+cmp_wakeup_ns (const struct heap_elem *a, const struct heap_elem *b,
+               void *aux UNUSED)
+{
+  struct thread *thread_a = heap_entry (a, struct thread, sleep_elem);
+  struct thread *thread_b = heap_entry (b, struct thread, sleep_elem);
+
+  return thread_a->wakeup_ns < thread_b->wakeup_ns;
+}
+
+/* hrsleep_heap에서 가장 이른 deadline까지 남은 시간을 PIT cycle 단위로
+   올림해서 반환한다. 이미 지났으면 0, 1초 이상 남았거나 잠든 스레드가
+   없으면 UINT32_MAX를 반환한다. */
+static uint32_t
+hrsleep_cycles (void)
+{
+  int64_t ns;
+
+  if (heap_empty (&hrsleep_heap))
+    return UINT32_MAX;
+
+  ns = heap_entry (heap_top (&hrsleep_heap), struct thread,
+                   sleep_elem)->wakeup_ns - timer_ns ();
+  if (ns <= 0)
+    return 0;
+  if (ns >= NSEC_PER_SEC)
+    return UINT32_MAX;
+  return (ns * PIT_HZ + NSEC_PER_SEC - 1) / NSEC_PER_SEC;
+}
+
+/* hrsleep_heap에서 deadline이 지난 스레드들을 깨운다.
+   timer interrupt 안에서 호출된다. */
+static void
+hrsleep_wake (void)
+{
+  int64_t now;
+  bool woken = false;
+
+  if (heap_empty (&hrsleep_heap))
+    return;
+
+  now = timer_ns () + HRSLEEP_SLACK_NS;
+  while (!heap_empty (&hrsleep_heap))
+    {
+      struct thread *t = heap_entry (heap_top (&hrsleep_heap), struct thread,
+                                     sleep_elem);
+      if (t->wakeup_ns > now)
+        break;
+      heap_pop (&hrsleep_heap);
+      thread_unblock (t);
+      woken = true;
+    }
+
+  /* 짧은 sleep은 지연에 민감하므로 다음 tick까지 기다리지 않고 선점한다. */
+  if (woken)
+    test_max_priority ();
+}
+
+/* hrsleep_heap의 가장 이른 deadline이 이미 예정된 다음 timer interrupt보다
+   먼저 오면, 그 deadline에 interrupt가 오도록 PIT를 one-shot으로 설정한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+hrsleep_arm (void)
+{
+  unsigned phase, expiry;
+  uint32_t hr;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (heap_empty (&hrsleep_heap))
+    return;
+
+  if (oneshot_armed)
+    {
+      /* 이미 만료되었다면 대기 중인 interrupt가 처리하고,
+         tickless idle의 긴 one-shot은 timer_idle_exit()이 정리한다. */
+      if (oneshot_ticks > 1 || pit_output_high (0))
+        return;
+      expiry = oneshot_phase + oneshot_count;
+      phase = expiry - pit_read_counter (0);
+    }
+  else
+    {
+      expiry = PIT_PER_TICK;
+      phase = PIT_PER_TICK - pit_read_counter (0);
+      if (phase >= PIT_PER_TICK)
+        phase = 0;
+    }
+
+  hr = hrsleep_cycles ();
+  if (hr >= expiry - phase)
+    return;
+  oneshot_arm (phase, hr > 0 ? hr : 1);
+}
+
+/* 현재 tick에서 이미 PHASE PIT cycle이 지났을 때, COUNT cycle 뒤에
+   interrupt가 한 번 발생하도록 PIT를 one-shot 모드로 설정한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+oneshot_arm (unsigned phase, uint32_t count)
+{
+  ASSERT (count > 0 && count <= UINT16_MAX);
+
+  pit_configure_oneshot (0, count);
+  oneshot_armed = true;
+  oneshot_count = count;
+  oneshot_phase = phase;
+  oneshot_ticks = (phase + count) / PIT_PER_TICK;
+}
+
+/* 현재 tick에서 이미 PHASE PIT cycle이 지났을 때, 다음 tick 경계와
+   hrsleep_heap의 가장 이른 deadline 중 먼저 오는 때에 interrupt가
+   한 번 발생하도록 one-shot을 설정한다. */
+static void
+oneshot_arm_next (unsigned phase)
+{
+  uint32_t count = PIT_PER_TICK - phase;
+  uint32_t hr = hrsleep_cycles ();
+
+  if (hr < count)
+    count = hr > 0 ? hr : 1;
+  oneshot_arm (phase, count);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -232,7 +620,14 @@ real_time_sleep (int64_t num, int32_t denom)
   int64_t ticks = num * TIMER_FREQ / denom;
 
   ASSERT (intr_get_level () == INTR_ON);
-  if (ticks > 0)
+  if (tsc_hz != 0)
+    {
+      /* TSC를 측정한 뒤에는 tick 단위로 내림하지 않고 정확한 deadline에
+         one-shot interrupt로 깨어난다. tick보다 짧은 sleep도 CPU를 양보한다. */
+      ASSERT (NSEC_PER_SEC % denom == 0);
+      timer_sleep_until_ns (timer_ns () + num * (NSEC_PER_SEC / denom));
+    }
+  else if (ticks > 0)
     {
       /* We're waiting for at least one full timer tick.  Use
          timer_sleep() because it will yield the CPU to other
@@ -254,5 +649,13 @@ real_time_delay (int64_t num, int32_t denom)
   /* Scale the numerator and denominator down by 1000 to avoid
      the possibility of overflow. */
   ASSERT (denom % 1000 == 0);
+  if (tsc_hz != 0)
+    {
+      /* TSC를 측정한 뒤에는 TSC로 정확하게 기다린다. */
+      int64_t deadline = timer_ns () + num * (NSEC_PER_SEC / denom);
+      while (timer_ns () < deadline)
+        barrier ();
+      return;
+    }
   busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000)); 
 }
@@ -2,6 +2,7 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -13,11 +14,16 @@ void timer_calibrate (void);
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
 
+/* 부팅 이후 지난 시간 (ns). TSC를 PIT에 맞춰 보정해서 측정한다. */
+int64_t timer_ns (void);
+uint64_t timer_tsc_hz (void);
+
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
+void timer_sleep_until_ns (int64_t deadline);
 
 /* Busy waits. */
 void timer_mdelay (int64_t milliseconds);
@@ -26,4 +32,22 @@ void timer_ndelay (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Tickless idle. */
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+/* timer interrupt 처리 시간 통계 (TSC cycle 단위). */
+void timer_irq_stats (uint64_t *max_cycles, uint64_t *avg_cycles);
+void timer_irq_stats_reset (void);
+
+/* CPU의 time stamp counter 값을 읽어온다. */
+static inline uint64_t
+timer_tsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
 #endif /* devices/timer.h */
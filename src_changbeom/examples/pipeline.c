@@ -0,0 +1,108 @@
+/* pipeline.c
+
+   Reads a file in one thread while another thread computes a
+   checksum over the blocks already read, so that the disk and
+   the CPU are busy at the same time.  The two threads share a
+   small ring of buffers guarded by a futex-based mutex and two
+   condition variables.
+
+   Usage: pipeline FILE */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <syscall.h>
+
+#define BLOCK_SIZE 512          /* Bytes per read() call. */
+#define RING_SIZE 8             /* Blocks in the ring. */
+
+static char ring[RING_SIZE][BLOCK_SIZE];
+static int ring_len[RING_SIZE]; /* Bytes in each block, 0 at EOF. */
+static int head, tail;          /* Next block to consume, to fill. */
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t not_full = PTHREAD_COND_INITIALIZER;
+
+/* Reads the file open as *AUX into the ring until EOF. */
+static void
+reader (void *aux)
+{
+  int fd = *(int *) aux;
+  int n;
+
+  do
+    {
+      pthread_mutex_lock (&mutex);
+      while (tail - head == RING_SIZE)
+        pthread_cond_wait (&not_full, &mutex);
+      pthread_mutex_unlock (&mutex);
+
+      /* 버퍼의 이 칸은 소비자가 아직 보지 않으므로 lock 없이 채운다. */
+      n = read (fd, ring[tail % RING_SIZE], BLOCK_SIZE);
+      if (n < 0)
+        n = 0;
+
+      pthread_mutex_lock (&mutex);
+      ring_len[tail % RING_SIZE] = n;
+      tail++;
+      pthread_cond_signal (&not_empty);
+      pthread_mutex_unlock (&mutex);
+    }
+  while (n > 0);
+}
+
+int
+main (int argc, char *argv[])
+{
+  unsigned sum = 0;
+  int bytes = 0;
+  int fd, n, i;
+  tid_t tid;
+
+  if (argc != 2)
+    {
+      printf ("usage: pipeline FILE\n");
+      return EXIT_FAILURE;
+    }
+
+  fd = open (argv[1]);
+  if (fd < 0)
+    {
+      printf ("%s: open failed\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+
+  tid = thread_create (reader, &fd);
+  if (tid == TID_ERROR)
+    {
+      printf ("thread_create failed\n");
+      return EXIT_FAILURE;
+    }
+
+  do
+    {
+      const unsigned char *block;
+
+      pthread_mutex_lock (&mutex);
+      while (head == tail)
+        pthread_cond_wait (&not_empty, &mutex);
+      pthread_mutex_unlock (&mutex);
+
+      block = (const unsigned char *) ring[head % RING_SIZE];
+      n = ring_len[head % RING_SIZE];
+      for (i = 0; i < n; i++)
+        sum = (sum << 5 | sum >> 27) ^ block[i];
+      bytes += n;
+
+      pthread_mutex_lock (&mutex);
+      head++;
+      pthread_cond_signal (&not_full);
+      pthread_mutex_unlock (&mutex);
+    }
+  while (n > 0);
+
+  thread_join (tid);
+  close (fd);
+  printf ("%s: %d bytes, checksum %08x\n", argv[1], bytes, sum);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/* simdmult.c
+
+   Multiplies two matrices once with scalar code, as matmult.c
+   does, and once with SSE2 vector instructions, checks that the
+   results agree, and reports the cycles each one took.
+
+   The SSE2 half relies on the kernel saving and restoring the
+   SSE registers of each process that uses them. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+
+#define DIM 128
+
+/* Four ints in one SSE register. */
+typedef int v4si __attribute__ ((vector_size (16)));
+
+static int A[DIM][DIM] __attribute__ ((aligned (16)));
+static int B[DIM][DIM] __attribute__ ((aligned (16)));
+static int C[DIM][DIM] __attribute__ ((aligned (16)));
+static int D[DIM][DIM] __attribute__ ((aligned (16)));
+
+/* Returns the time stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+int
+main (void)
+{
+  uint64_t start, scalar, simd;
+  int i, j, k;
+
+  /* Initialize the matrices. */
+  for (i = 0; i < DIM; i++)
+    for (j = 0; j < DIM; j++)
+      {
+	A[i][j] = i + j;
+	B[i][j] = i - j;
+	C[i][j] = 0;
+	D[i][j] = 0;
+      }
+
+  /* Scalar multiply. */
+  start = rdtsc ();
+  for (i = 0; i < DIM; i++)	
+    for (j = 0; j < DIM; j++)
+      for (k = 0; k < DIM; k++)
+	C[i][j] += A[i][k] * B[k][j];
+  scalar = rdtsc () - start;
+
+  /* SSE2 multiply: each step adds A[i][k] times four elements of
+     row K of B to four elements of row I of D. */
+  start = rdtsc ();
+  for (i = 0; i < DIM; i++)
+    for (k = 0; k < DIM; k++)
+      {
+        v4si a = { A[i][k], A[i][k], A[i][k], A[i][k] };
+        v4si *b = (v4si *) B[k];
+        v4si *d = (v4si *) D[i];
+
+        for (j = 0; j < DIM / 4; j++)
+          d[j] += a * b[j];
+      }
+  simd = rdtsc () - start;
+
+  for (i = 0; i < DIM; i++)
+    for (j = 0; j < DIM; j++)
+      if (C[i][j] != D[i][j])
+        {
+          printf ("simdmult: mismatch at [%d][%d]: %d != %d\n",
+                  i, j, C[i][j], D[i][j]);
+          return EXIT_FAILURE;
+        }
+
+  printf ("simdmult: %dx%d scalar %llu cycles, sse2 %llu cycles\n",
+          DIM, DIM, scalar, simd);
+  return EXIT_SUCCESS;
+}
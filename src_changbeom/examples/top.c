@@ -0,0 +1,170 @@
+/* top.c
+
+   Samples the per-thread scheduler statistics once a second and
+   prints where CPU time went during each interval, busiest
+   threads first.
+
+   Usage: top [SAMPLES] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+#define MAX_THREADS 64          /* Threads shown per sample. */
+#define INTERVAL 100            /* Sampling interval, in timer ticks. */
+
+static struct thread_stat prev[MAX_THREADS], cur[MAX_THREADS];
+static int prev_cnt, cur_cnt;
+
+/* One row of output: a thread and its counters for the last
+   interval. */
+struct row
+  {
+    const struct thread_stat *s;
+    int64_t run, ready, sync, sleep;
+    unsigned vcsw, ivcsw;
+  };
+static struct row rows[MAX_THREADS];
+
+static const char *status_name (int status);
+static const struct thread_stat *find (const struct thread_stat *, int cnt,
+                                       int tid);
+static int64_t total_run_ticks (const struct thread_stat *, int cnt);
+static int compare_rows (const void *, const void *);
+
+int
+main (int argc, char *argv[]) 
+{
+  int samples = argc > 1 ? atoi (argv[1]) : 5;
+  int i, n;
+
+  prev_cnt = threadstat (prev, MAX_THREADS);
+  if (prev_cnt < 0)
+    {
+      printf ("top: threadstat failed\n");
+      return EXIT_FAILURE;
+    }
+
+  for (n = 0; n < samples; n++) 
+    {
+      int64_t elapsed;
+      bool edf_header = true;
+
+      /* The run ticks of all threads, idle included, add up to
+         the elapsed time, so we can use them as our clock. */
+      do
+        {
+          cur_cnt = threadstat (cur, MAX_THREADS);
+          elapsed = total_run_ticks (cur, cur_cnt)
+                    - total_run_ticks (prev, prev_cnt);
+        }
+      while (elapsed >= 0 && elapsed < INTERVAL);
+      if (elapsed <= 0)
+        elapsed = 1;
+
+      for (i = 0; i < cur_cnt; i++) 
+        {
+          const struct thread_stat *s = &cur[i];
+          const struct thread_stat *p = find (prev, prev_cnt, s->tid);
+          struct row *r = &rows[i];
+
+          r->s = s;
+          r->run = s->run_ticks - (p != NULL ? p->run_ticks : 0);
+          r->ready = s->ready_ticks - (p != NULL ? p->ready_ticks : 0);
+          r->sync = s->sync_ticks - (p != NULL ? p->sync_ticks : 0);
+          r->sleep = s->sleep_ticks - (p != NULL ? p->sleep_ticks : 0);
+          r->vcsw = s->voluntary_switches
+                    - (p != NULL ? p->voluntary_switches : 0);
+          r->ivcsw = s->involuntary_switches
+                     - (p != NULL ? p->involuntary_switches : 0);
+        }
+      qsort (rows, cur_cnt, sizeof *rows, compare_rows);
+
+      printf ("\n%d threads, %lld ticks\n", cur_cnt, elapsed);
+      printf ("  TID NAME             STATE PRI NICE  %%CPU   READY "
+              "MAXREADY    SYNC   SLEEP  VCSW IVCSW\n");
+      for (i = 0; i < cur_cnt; i++) 
+        {
+          const struct row *r = &rows[i];
+          printf ("%5d %-16s %-5s %3d %4d %5lld %7lld %8lld %7lld %7lld "
+                  "%5u %5u\n",
+                  r->s->tid, r->s->name, status_name (r->s->status),
+                  r->s->priority, r->s->nice, r->run * 100 / elapsed,
+                  r->ready, r->s->max_ready_ticks, r->sync, r->sleep,
+                  r->vcsw, r->ivcsw);
+        }
+
+      /* Periodic (EDF) threads, with their lifetime job counts. */
+      for (i = 0; i < cur_cnt; i++) 
+        {
+          const struct thread_stat *s = rows[i].s;
+          if (s->edf_period == 0)
+            continue;
+          if (edf_header) 
+            {
+              printf ("  TID NAME             PERIOD BUDGET    JOBS  MISSES "
+                      "OVERRUNS\n");
+              edf_header = false;
+            }
+          printf ("%5d %-16s %6lld %6lld %7u %7u %8u\n",
+                  s->tid, s->name, s->edf_period, s->edf_budget,
+                  s->edf_jobs, s->edf_misses, s->edf_overruns);
+        }
+
+      memcpy (prev, cur, sizeof cur);
+      prev_cnt = cur_cnt;
+    }
+  return EXIT_SUCCESS;
+}
+
+/* Returns a short name for thread status STATUS. */
+static const char *
+status_name (int status) 
+{
+  switch (status) 
+    {
+    case THREAD_STAT_RUNNING: return "RUN";
+    case THREAD_STAT_READY: return "READY";
+    case THREAD_STAT_BLOCKED: return "BLOCK";
+    default: return "DYING";
+    }
+}
+
+/* Returns the entry for TID among the CNT entries in STATS, or a
+   null pointer if TID was not alive then. */
+static const struct thread_stat *
+find (const struct thread_stat *stats, int cnt, int tid) 
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    if (stats[i].tid == tid)
+      return &stats[i];
+  return NULL;
+}
+
+/* Returns the sum of the run ticks of the CNT entries in STATS. */
+static int64_t
+total_run_ticks (const struct thread_stat *stats, int cnt) 
+{
+  int64_t sum = 0;
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    sum += stats[i].run_ticks;
+  return sum;
+}
+
+/* Orders rows by CPU time used during the interval, busiest
+   first. */
+static int
+compare_rows (const void *a_, const void *b_) 
+{
+  const struct row *a = a_;
+  const struct row *b = b_;
+
+  if (a->run != b->run)
+    return a->run > b->run ? -1 : 1;
+  return a->s->tid - b->s->tid;
+}
@@ -2,6 +2,9 @@
 #include <debug.h>
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/interrupt.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* An open file. */
 struct file 
@@ -9,26 +12,42 @@ struct file
     struct inode *inode;        /* File's inode. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
+    int ref_cnt;                /* file_close()가 해제하기 전까지 남은 참조 수. */
+    struct lock pos_lock;       /* POS를 읽고 바꾸는 것을 직렬화한다. */
   };
 
+/* struct file들의 cache. */
+static struct kmem_cache *file_cache;
+
+/* Initializes the file module. */
+void
+file_init (void)
+{
+  file_cache = kmem_cache_create ("file", sizeof (struct file), NULL);
+  if (file_cache == NULL)
+    PANIC ("file_init: out of memory");
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
    and returns the new file.  Returns a null pointer if an
    allocation fails or if INODE is null. */
 struct file *
 file_open (struct inode *inode) 
 {
-  struct file *file = calloc (1, sizeof *file);
+  struct file *file = kmem_cache_alloc (file_cache);
   if (inode != NULL && file != NULL)
     {
       file->inode = inode;
       file->pos = 0;
       file->deny_write = false;
+      file->ref_cnt = 1;
+      lock_init (&file->pos_lock);
       return file;
     }
   else
     {
       inode_close (inode);
-      free (file);
+      kmem_cache_free (file_cache, file);
       return NULL; 
     }
 }
@@ -41,15 +60,62 @@ file_reopen (struct file *file)
   return file_open (inode_reopen (file->inode));
 }
 
-/* Closes FILE. */
+/* FILE의 참조를 하나 늘린다. 같은 프로세스의 다른 스레드가 FILE을
+   사용하는 도중에 close()해도 해제되지 않도록, 시스템 콜이 FDT에서 꺼낸
+   FILE을 쓰는 동안 잡아둔다. 늘린 참조는 file_unpin()이나 file_close()로
+   놓는다. */
+void
+file_pin (struct file *file)
+{
+  enum intr_level old_level;
+
+  ASSERT (file != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (file->ref_cnt > 0);
+  file->ref_cnt++;
+  intr_set_level (old_level);
+}
+
+/* FILE의 참조가 마지막 하나가 아니면 하나 줄이고 true를 반환한다.
+   마지막 참조이면 아무것도 하지 않고 false를 반환하므로, 호출한 쪽에서
+   필요한 lock을 잡고 file_close()를 호출해야 한다. */
+bool
+file_unpin (struct file *file)
+{
+  enum intr_level old_level;
+  bool unpinned = false;
+
+  ASSERT (file != NULL);
+
+  old_level = intr_disable ();
+  if (file->ref_cnt > 1)
+    {
+      file->ref_cnt--;
+      unpinned = true;
+    }
+  intr_set_level (old_level);
+  return unpinned;
+}
+
+/* Closes FILE.  FILE은 마지막 참조가 닫힐 때 해제된다. */
 void
 file_close (struct file *file) 
 {
+  enum intr_level old_level;
+  int ref_cnt;
+
   if (file != NULL)
     {
+      old_level = intr_disable ();
+      ref_cnt = --file->ref_cnt;
+      intr_set_level (old_level);
+      if (ref_cnt > 0)
+        return;
+
       file_allow_write (file);
       inode_close (file->inode);
-      free (file); 
+      kmem_cache_free (file_cache, file);
     }
 }
 
@@ -68,8 +134,12 @@ file_get_inode (struct file *file)
 off_t
 file_read (struct file *file, void *buffer, off_t size) 
 {
-  off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+  off_t bytes_read;
+
+  lock_acquire (&file->pos_lock);
+  bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_read;
+  lock_release (&file->pos_lock);
   return bytes_read;
 }
 
@@ -94,8 +164,12 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs)
 off_t
 file_write (struct file *file, const void *buffer, off_t size) 
 {
-  off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+  off_t bytes_written;
+
+  lock_acquire (&file->pos_lock);
+  bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_written;
+  lock_release (&file->pos_lock);
   return bytes_written;
 }
 
@@ -155,7 +229,9 @@ file_seek (struct file *file, off_t new_pos)
 {
   ASSERT (file != NULL);
   ASSERT (new_pos >= 0);
+  lock_acquire (&file->pos_lock);
   file->pos = new_pos;
+  lock_release (&file->pos_lock);
 }
 
 /* Returns the current position in FILE as a byte offset from the
@@ -163,6 +239,11 @@ file_seek (struct file *file, off_t new_pos)
 off_t
 file_tell (struct file *file) 
 {
+  off_t pos;
+
   ASSERT (file != NULL);
-  return file->pos;
+  lock_acquire (&file->pos_lock);
+  pos = file->pos;
+  lock_release (&file->pos_lock);
+  return pos;
 }
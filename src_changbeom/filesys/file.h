@@ -1,15 +1,20 @@
 #ifndef FILESYS_FILE_H
 #define FILESYS_FILE_H
 
+#include <stdbool.h>
 #include "filesys/off_t.h"
 
 struct inode;
 struct file;
 
+void file_init (void);
+
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 void file_close (struct file *);
+void file_pin (struct file *);
+bool file_unpin (struct file *);
 struct inode *file_get_inode (struct file *);
 
 /* Reading and writing. */
@@ -25,6 +25,7 @@ filesys_init (bool format)
   // buffer cache 초기화. 파일시스템 초기화 하기 전에 먼저 해줘야함
   bc_init ();
   inode_init ();
+  file_init ();
   free_map_init ();
 
   if (format) 
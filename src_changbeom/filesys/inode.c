@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "filesys/buffer_cache.h"
 
 /* Identifies an inode. */
@@ -343,12 +344,27 @@ static void free_inode_sectors (struct inode_disk *inode_disk) {
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* struct inode들의 cache. */
+static struct kmem_cache *inode_cache;
+
+/* inode_cache의 constructor. 닫힌 inode의 extend_lock은 풀려 있으므로
+   lock은 slab에 처음 만들어질 때 한 번만 초기화하면 된다. */
+static void
+inode_ctor (void *inode_)
+{
+  struct inode *inode = inode_;
+  lock_init (&inode->extend_lock);
+}
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   ASSERT (sizeof (struct inode_disk) == BLOCK_SECTOR_SIZE);
   list_init (&open_inodes);
+  inode_cache = kmem_cache_create ("inode", sizeof (struct inode), inode_ctor);
+  if (inode_cache == NULL)
+    PANIC ("inode_init: out of memory");
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -415,13 +431,12 @@ struct inode *inode_open (block_sector_t sector) {
   }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = kmem_cache_alloc (inode_cache);
   if (inode == NULL)
     return NULL;
 
   /* Initialize. */
   list_push_front (&open_inodes, &inode->elem);
-  lock_init (&inode->extend_lock);
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
@@ -477,7 +492,7 @@ inode_close (struct inode *inode)
 
     /*  disk_inode 변수 할당 해제 (free() 이용) */
     free (disk_inode);
-    free (inode); 
+    kmem_cache_free (inode_cache, inode);
   }
 }
 
@@ -23,11 +23,16 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   bitmap_add_summary()로 summary를 붙이면 FULL의 bit K는 BITS[K]의
+   모든 bit가 true일 때만 true이다.  false인 bit를 찾을 때 FULL을 보고
+   가득 찬 element들을 한 번에 건너뛴다. */
 struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    elem_type *full;    /* 가득 찬 element들의 summary, 없으면 null. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -68,6 +73,98 @@ last_mask (const struct bitmap *b)
   int last_bits = b->bit_cnt % ELEM_BITS;
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns an elem_type in which the bits numbered FROM through
+   TO - 1 of an element are set to 1 and the rest are set to 0.
+   0 <= FROM < TO <= ELEM_BITS. */
+static inline elem_type
+range_mask (size_t from, size_t to)
+{
+  elem_type mask = (elem_type) -1 << from;
+  if (to < ELEM_BITS)
+    mask &= ((elem_type) 1 << to) - 1;
+  return mask;
+}
+
+/* Returns the index of the lowest set bit in W, which must be
+   nonzero.  See the description of the BSF instruction in
+   [IA32-v2a]. */
+static inline size_t
+lowest_bit (elem_type w)
+{
+  elem_type idx;
+  asm ("bsfl %1, %0" : "=r" (idx) : "rm" (w) : "cc");
+  return idx;
+}
+
+/* Returns the number of set bits in W. */
+static inline size_t
+popcount (elem_type w)
+{
+  w = w - ((w >> 1) & 0x55555555);
+  w = (w & 0x33333333) + ((w >> 2) & 0x33333333);
+  w = (w + (w >> 4)) & 0x0f0f0f0f;
+  return (w * 0x01010101) >> 24;
+}
+
+/* B에 summary가 있으면 B의 IDX번째 element가 가득 찼는지를 다시 적는다. */
+static inline void
+update_summary (struct bitmap *b, size_t idx)
+{
+  if (b->full != NULL)
+    {
+      if (b->bits[idx] == (elem_type) -1)
+        b->full[elem_idx (idx)] |= bit_mask (idx);
+      else
+        b->full[elem_idx (idx)] &= ~bit_mask (idx);
+    }
+}
+
+/* B의 START 이상 END 미만인 bit들 중 VALUE인 첫 bit의 번호를 반환한다.
+   없으면 END를 반환한다.  한 번에 element 하나씩 보고, false를 찾을 때
+   summary가 있으면 가득 찬 element들은 보지 않고 건너뛴다. */
+static size_t
+find_next (const struct bitmap *b, size_t start, size_t end, bool value)
+{
+  elem_type flip = value ? 0 : (elem_type) -1;
+  size_t idx, last_idx;
+  elem_type w;
+
+  ASSERT (end <= b->bit_cnt);
+  if (start >= end)
+    return end;
+
+  idx = elem_idx (start);
+  last_idx = elem_idx (end - 1);
+  w = (b->bits[idx] ^ flip) & ((elem_type) -1 << (start % ELEM_BITS));
+  while (w == 0)
+    {
+      if (++idx > last_idx)
+        return end;
+
+      if (!value && b->full != NULL && (b->full[elem_idx (idx)]
+                                        & bit_mask (idx)) != 0)
+        {
+          /* 가득 차지 않은 다음 element를 summary에서 찾는다. */
+          size_t sidx = elem_idx (idx);
+          elem_type sw = ~b->full[sidx] & ((elem_type) -1 << (idx % ELEM_BITS));
+
+          while (sw == 0)
+            {
+              if (++sidx > elem_idx (last_idx))
+                return end;
+              sw = ~b->full[sidx];
+            }
+          idx = sidx * ELEM_BITS + lowest_bit (sw);
+          if (idx > last_idx)
+            return end;
+        }
+      w = b->bits[idx] ^ flip;
+    }
+
+  start = idx * ELEM_BITS + lowest_bit (w);
+  return start < end ? start : end;
+}
 
 /* Creation and destruction. */
 
@@ -82,6 +179,7 @@ bitmap_create (size_t bit_cnt)
   if (b != NULL)
     {
       b->bit_cnt = bit_cnt;
+      b->full = NULL;
       b->bits = malloc (byte_cnt (bit_cnt));
       if (b->bits != NULL || bit_cnt == 0)
         {
@@ -104,6 +202,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
   ASSERT (block_size >= bitmap_buf_size (bit_cnt));
 
   b->bit_cnt = bit_cnt;
+  b->full = NULL;
   b->bits = (elem_type *) (b + 1);
   bitmap_set_all (b, false);
   return b;
@@ -117,6 +216,27 @@ bitmap_buf_size (size_t bit_cnt)
   return sizeof (struct bitmap) + byte_cnt (bit_cnt);
 }
 
+/* B에 가득 찬 element들의 summary를 붙인다.  그 뒤로는 false인 bit를
+   찾을 때 가득 찬 부분을 element 32개씩 건너뛴다.  거의 다 찬 큰
+   bitmap에 유용하다.  메모리가 없으면 false를 반환하고 B는 summary
+   없이 그대로 쓸 수 있다. */
+bool
+bitmap_add_summary (struct bitmap *b)
+{
+  size_t i;
+
+  ASSERT (b != NULL);
+  if (b->full != NULL)
+    return true;
+
+  b->full = calloc (elem_cnt (elem_cnt (b->bit_cnt)) + 1, sizeof (elem_type));
+  if (b->full == NULL)
+    return false;
+  for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+    update_summary (b, i);
+  return true;
+}
+
 /* Destroys bitmap B, freeing its storage.
    Not for use on bitmaps created by
    bitmap_create_preallocated(). */
@@ -125,6 +245,7 @@ bitmap_destroy (struct bitmap *b)
 {
   if (b != NULL) 
     {
+      free (b->full);
       free (b->bits);
       free (b);
     }
@@ -164,6 +285,7 @@ bitmap_mark (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the OR instruction in [IA32-v2b]. */
   asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -177,6 +299,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the AND instruction in [IA32-v2a]. */
   asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -192,6 +315,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -214,18 +338,33 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
+  size_t end = start + cnt;
+
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  while (start < end)
+    {
+      size_t idx = elem_idx (start);
+      size_t to = end - idx * ELEM_BITS < ELEM_BITS
+                  ? end - idx * ELEM_BITS : ELEM_BITS;
+      elem_type mask = range_mask (start % ELEM_BITS, to);
+
+      /* See bitmap_mark() and bitmap_reset(). */
+      if (value)
+        asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+      else
+        asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+      update_summary (b, idx);
+
+      start = (idx + 1) * ELEM_BITS;
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -233,17 +372,24 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i, value_cnt;
+  size_t end = start + cnt;
+  size_t value_cnt;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
-  return value_cnt;
+  while (start < end)
+    {
+      size_t idx = elem_idx (start);
+      size_t to = end - idx * ELEM_BITS < ELEM_BITS
+                  ? end - idx * ELEM_BITS : ELEM_BITS;
+
+      value_cnt += popcount (b->bits[idx] & range_mask (start % ELEM_BITS, to));
+      start = (idx + 1) * ELEM_BITS;
+    }
+  return value ? value_cnt : cnt - value_cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -251,16 +397,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_next (b, start, start + cnt, value) != start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -302,10 +443,24 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+
+      /* VALUE인 bit를 찾고, 거기서부터 CNT개 안에 !VALUE가 있으면
+         그 다음 bit부터 다시 찾는다.  각 bit를 많아야 두 번 본다. */
+      while (i <= last)
+        {
+          size_t end;
+
+          if (cnt == 0)
+            return i;
+          i = find_next (b, i, b->bit_cnt, value);
+          if (i > last)
+            break;
+          end = find_next (b, i, i + cnt, !value);
+          if (end == i + cnt)
+            return i;
+          i = end + 1;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -345,8 +500,12 @@ bitmap_read (struct bitmap *b, struct file *file)
   if (b->bit_cnt > 0) 
     {
       off_t size = byte_cnt (b->bit_cnt);
+      size_t i;
+
       success = file_read_at (file, b->bits, size, 0) == size;
       b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+      for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+        update_summary (b, i);
     }
   return success;
 }
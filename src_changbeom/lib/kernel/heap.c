@@ -0,0 +1,192 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* 부모-자식 관계에 들어있지 않은 두 트리 A, B를 합쳐서 새 root를 반환한다.
+   둘 중 작은 쪽이 root가 되고, 다른 쪽은 root의 첫번째 자식이 된다. */
+static struct heap_elem *
+meld (struct heap *heap, struct heap_elem *a, struct heap_elem *b)
+{
+  struct heap_elem *t;
+
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+
+  if (heap->less (b, a, heap->aux))
+    {
+      t = a;
+      a = b;
+      b = t;
+    }
+
+  /* B를 A의 첫번째 자식으로 붙인다. */
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+
+  a->next = a->prev = NULL;
+  return a;
+}
+
+/* FIRST부터 시작하는 형제 리스트를 two-pass 방식으로 합쳐서
+   하나의 트리로 만들고 그 root를 반환한다.
+   첫번째 pass에서 왼쪽부터 두개씩 짝지어 합치고,
+   두번째 pass에서 오른쪽부터 차례로 합친다. */
+static struct heap_elem *
+merge_pairs (struct heap *heap, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *result = NULL;
+
+  /* 첫번째 pass. 합친 결과들은 next로 연결된 스택에 쌓이므로
+     스택의 맨 위가 가장 오른쪽 결과가 된다. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = first->next;
+      struct heap_elem *m;
+
+      if (b != NULL)
+        {
+          first = b->next;
+          a->next = a->prev = b->next = b->prev = NULL;
+          m = meld (heap, a, b);
+        }
+      else
+        {
+          first = NULL;
+          a->next = a->prev = NULL;
+          m = a;
+        }
+      m->next = pairs;
+      pairs = m;
+    }
+
+  /* 두번째 pass. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *next = pairs->next;
+      pairs->next = NULL;
+      result = meld (heap, result, pairs);
+      pairs = next;
+    }
+  return result;
+}
+
+/* Initializes HEAP as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux)
+{
+  ASSERT (heap != NULL);
+  ASSERT (less != NULL);
+
+  heap->root = NULL;
+  heap->size = 0;
+  heap->less = less;
+  heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+heap_push (struct heap *heap, struct heap_elem *elem)
+{
+  ASSERT (heap != NULL);
+  ASSERT (elem != NULL);
+
+  elem->child = elem->next = elem->prev = NULL;
+  heap->root = meld (heap, heap->root, elem);
+  heap->size++;
+}
+
+/* Returns the top (least) element of HEAP, or a null pointer if
+   HEAP is empty. */
+struct heap_elem *
+heap_top (const struct heap *heap)
+{
+  ASSERT (heap != NULL);
+
+  return heap->root;
+}
+
+/* Removes the top element from HEAP and returns it, or returns
+   a null pointer if HEAP is empty. */
+struct heap_elem *
+heap_pop (struct heap *heap)
+{
+  struct heap_elem *top;
+
+  ASSERT (heap != NULL);
+
+  top = heap->root;
+  if (top == NULL)
+    return NULL;
+
+  heap->root = merge_pairs (heap, top->child);
+  heap->size--;
+  top->child = top->next = top->prev = NULL;
+  return top;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem)
+{
+  struct heap_elem *sub;
+
+  ASSERT (heap != NULL);
+  ASSERT (elem != NULL);
+  ASSERT (heap->size > 0);
+
+  if (elem == heap->root)
+    {
+      heap_pop (heap);
+      return;
+    }
+
+  /* ELEM을 부모의 자식 리스트에서 떼어낸다.
+     prev의 첫번째 자식이 ELEM이라면 prev는 부모이다. */
+  ASSERT (elem->prev != NULL);
+  if (elem->prev->child == elem)
+    elem->prev->child = elem->next;
+  else
+    elem->prev->next = elem->next;
+  if (elem->next != NULL)
+    elem->next->prev = elem->prev;
+
+  /* ELEM의 자식들을 하나로 합쳐서 다시 heap에 붙인다. */
+  sub = merge_pairs (heap, elem->child);
+  heap->root = meld (heap, heap->root, sub);
+  heap->size--;
+  elem->child = elem->next = elem->prev = NULL;
+}
+
+/* Restores the heap order of HEAP after the value that ELEM is
+   ordered by has changed. */
+void
+heap_update (struct heap *heap, struct heap_elem *elem)
+{
+  heap_remove (heap, elem);
+  heap_push (heap, elem);
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (const struct heap *heap)
+{
+  ASSERT (heap != NULL);
+
+  return heap->size;
+}
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool
+heap_empty (const struct heap *heap)
+{
+  ASSERT (heap != NULL);
+
+  return heap->root == NULL;
+}
@@ -0,0 +1,67 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Pairing heap.
+
+   list.h와 같은 방식으로, heap에 넣을 구조체 안에 struct heap_elem
+   멤버를 두고 heap_entry()로 원래 구조체를 찾아가는 intrusive heap이다.
+   따라서 동적 할당이 필요 없어 interrupt handler 안에서도 사용할 수 있다.
+
+   heap_less_func 기준으로 가장 "작은" 원소가 heap의 top이 된다.
+   즉, 같은 비교 함수로 list_sort()를 했을 때 맨 앞에 오는 원소가 top이다.
+
+   시간 복잡도 (amortized):
+     heap_push, heap_top          O(1)
+     heap_pop, heap_remove        O(log n)
+     heap_update                  O(log n) */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem
+  {
+    struct heap_elem *child;    /* 첫번째 자식. */
+    struct heap_elem *next;     /* 다음 형제. */
+    struct heap_elem *prev;     /* 이전 형제, 첫번째 자식이면 부모. */
+  };
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap
+  {
+    struct heap_elem *root;     /* Top element, or null if empty. */
+    size_t size;                /* Number of elements. */
+    heap_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+        ((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+                     - offsetof (STRUCT, MEMBER.child)))
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+/* Basic operations. */
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (const struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+/* Properties. */
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
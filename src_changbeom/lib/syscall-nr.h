@@ -28,7 +28,19 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Scheduling. */
+    SYS_NICE,                   /* Change this process's nice value. */
+    SYS_THREADSTAT,             /* Reads per-thread scheduler statistics. */
+    SYS_TRACEDUMP,              /* Dumps the scheduler event trace. */
+
+    /* User threads. */
+    SYS_THREAD_CREATE,          /* Start a thread in this process. */
+    SYS_THREAD_JOIN,            /* Wait for a thread of this process. */
+    SYS_THREAD_EXIT,            /* Terminate the calling thread. */
+    SYS_FUTEX_WAIT,             /* Sleep while a user word holds a value. */
+    SYS_FUTEX_WAKE              /* Wake threads sleeping on a user word. */
   };
 
 #endif /* lib/syscall-nr.h */
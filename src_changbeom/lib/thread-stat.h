@@ -0,0 +1,37 @@
+#ifndef __LIB_THREAD_STAT_H
+#define __LIB_THREAD_STAT_H
+
+#include <stdint.h>
+
+/* threadstat 시스템콜이 스레드마다 하나씩 채워주는 스케줄러 통계.
+   커널과 유저 프로그램이 같은 구조체를 사용한다.
+   시간은 모두 timer tick 단위이다. */
+struct thread_stat
+  {
+    int tid;                            /* Thread identifier. */
+    char name[16];                      /* Name. */
+    int status;                         /* enum thread_status 값. */
+    int priority;                       /* 현재 (donation 포함) 우선순위. */
+    int nice;                           /* mlfqs nice 값. */
+    int64_t run_ticks;                  /* 실행 중이었던 시간. */
+    int64_t ready_ticks;                /* ready queue에서 기다린 시간. */
+    int64_t max_ready_ticks;            /* 한 번에 가장 오래 기다린 시간. */
+    int64_t sync_ticks;                 /* semaphore, lock, cond에 block된 시간. */
+    int64_t sleep_ticks;                /* timer_sleep()으로 잔 시간. */
+    int64_t other_ticks;                /* 그 밖의 이유로 block된 시간. */
+    unsigned voluntary_switches;        /* 스스로 CPU를 내어준 횟수. */
+    unsigned involuntary_switches;      /* 선점당한 횟수. */
+    int64_t edf_period;                 /* EDF 주기. EDF 스레드가 아니면 0. */
+    int64_t edf_budget;                 /* 주기마다 실행할 수 있는 시간. */
+    unsigned edf_jobs;                  /* 끝낸 job의 수. */
+    unsigned edf_misses;                /* deadline을 넘긴 job의 수. */
+    unsigned edf_overruns;              /* budget을 다 써서 멈춘 횟수. */
+  };
+
+/* thread_stat.status 값. threads/thread.h의 enum thread_status와 같다. */
+#define THREAD_STAT_RUNNING 0
+#define THREAD_STAT_READY 1
+#define THREAD_STAT_BLOCKED 2
+#define THREAD_STAT_DYING 3
+
+#endif /* lib/thread-stat.h */
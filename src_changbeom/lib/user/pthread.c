@@ -0,0 +1,122 @@
+#include <pthread.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* *P가 OLD이면 NEW로 바꾸고, 바꾸기 전의 *P 값을 반환한다. */
+static inline int
+atomic_cmpxchg (int *p, int old, int new)
+{
+  int prev;
+  asm volatile ("lock cmpxchgl %2, %1"
+                : "=a" (prev), "+m" (*p)
+                : "r" (new), "0" (old)
+                : "memory");
+  return prev;
+}
+
+/* *P를 V로 바꾸고 바꾸기 전의 값을 반환한다. */
+static inline int
+atomic_xchg (int *p, int v)
+{
+  asm volatile ("xchgl %0, %1" : "+r" (v), "+m" (*p) : : "memory");
+  return v;
+}
+
+/* *P에 V를 더하고 더하기 전의 값을 반환한다. */
+static inline int
+atomic_fetch_add (int *p, int v)
+{
+  asm volatile ("lock xaddl %0, %1" : "+r" (v), "+m" (*p) : : "memory");
+  return v;
+}
+
+/* Initializes MUTEX as unlocked. */
+void
+pthread_mutex_init (pthread_mutex_t *mutex)
+{
+  mutex->state = 0;
+}
+
+/* Acquires MUTEX, sleeping until it becomes available if
+   necessary.  If MUTEX is free, no system call is made. */
+void
+pthread_mutex_lock (pthread_mutex_t *mutex)
+{
+  int c = atomic_cmpxchg (&mutex->state, 0, 1);
+
+  if (c == 0)
+    return;
+
+  /* 기다리는 스레드가 있다고 표시한 뒤에 잠들어야
+     unlock하는 쪽이 futex_wake()를 부른다. */
+  if (c != 2)
+    c = atomic_xchg (&mutex->state, 2);
+  while (c != 0)
+    {
+      futex_wait (&mutex->state, 2);
+      c = atomic_xchg (&mutex->state, 2);
+    }
+}
+
+/* Tries to acquire MUTEX without sleeping.  Returns true if
+   successful, false if MUTEX is already locked. */
+bool
+pthread_mutex_trylock (pthread_mutex_t *mutex)
+{
+  return atomic_cmpxchg (&mutex->state, 0, 1) == 0;
+}
+
+/* Releases MUTEX, which the caller must hold.  Enters the
+   kernel only if another thread may be waiting for it. */
+void
+pthread_mutex_unlock (pthread_mutex_t *mutex)
+{
+  if (atomic_xchg (&mutex->state, 0) == 2)
+    futex_wake (&mutex->state, 1);
+}
+
+/* Initializes COND as a condition variable with no waiters. */
+void
+pthread_cond_init (pthread_cond_t *cond)
+{
+  cond->seq = 0;
+  cond->waiters = 0;
+}
+
+/* Atomically releases MUTEX and waits for COND to be signaled,
+   then reacquires MUTEX before returning.  As with any condition
+   variable, the caller should recheck its condition afterward. */
+void
+pthread_cond_wait (pthread_cond_t *cond, pthread_mutex_t *mutex)
+{
+  int seq = cond->seq;
+
+  atomic_fetch_add (&cond->waiters, 1);
+  pthread_mutex_unlock (mutex);
+
+  /* unlock 이후에 signal이 왔다면 seq가 바뀌었으므로 잠들지 않는다. */
+  futex_wait (&cond->seq, seq);
+  atomic_fetch_add (&cond->waiters, -1);
+
+  /* 다른 스레드가 함께 깨어났을 수 있으므로 경쟁 상태로 잠근다. */
+  while (atomic_xchg (&mutex->state, 2) != 0)
+    futex_wait (&mutex->state, 2);
+}
+
+/* Wakes one thread waiting on COND, if any. */
+void
+pthread_cond_signal (pthread_cond_t *cond)
+{
+  atomic_fetch_add (&cond->seq, 1);
+  if (cond->waiters > 0)
+    futex_wake (&cond->seq, 1);
+}
+
+/* Wakes all threads waiting on COND. */
+void
+pthread_cond_broadcast (pthread_cond_t *cond)
+{
+  atomic_fetch_add (&cond->seq, 1);
+  if (cond->waiters > 0)
+    futex_wake (&cond->seq, INT_MAX);
+}
@@ -0,0 +1,42 @@
+#ifndef __LIB_USER_PTHREAD_H
+#define __LIB_USER_PTHREAD_H
+
+#include <stdbool.h>
+
+/* futex 시스템콜 위에 만든 pthread 스타일의 mutex와 condition variable.
+   경쟁이 없으면 원자적 연산만으로 끝나고 커널에 들어가지 않는다. */
+
+/* Mutex.
+   state는 0이면 풀려있고, 1이면 잠겨있고, 2이면 잠겨있으면서
+   futex_wait()으로 기다리는 스레드가 있을 수 있다. */
+typedef struct
+  {
+    int state;
+  }
+pthread_mutex_t;
+
+#define PTHREAD_MUTEX_INITIALIZER { 0 }
+
+void pthread_mutex_init (pthread_mutex_t *);
+void pthread_mutex_lock (pthread_mutex_t *);
+bool pthread_mutex_trylock (pthread_mutex_t *);
+void pthread_mutex_unlock (pthread_mutex_t *);
+
+/* Condition variable.
+   seq는 signal마다 1씩 늘어나는 futex word이고,
+   waiters는 seq에서 기다리는 스레드의 수이다. */
+typedef struct
+  {
+    int seq;
+    int waiters;
+  }
+pthread_cond_t;
+
+#define PTHREAD_COND_INITIALIZER { 0, 0 }
+
+void pthread_cond_init (pthread_cond_t *);
+void pthread_cond_wait (pthread_cond_t *, pthread_mutex_t *);
+void pthread_cond_signal (pthread_cond_t *);
+void pthread_cond_broadcast (pthread_cond_t *);
+
+#endif /* lib/user/pthread.h */
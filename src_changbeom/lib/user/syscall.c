@@ -182,3 +182,60 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int
+nice (int increment)
+{
+  return syscall1 (SYS_NICE, increment);
+}
+
+int
+threadstat (struct thread_stat *stats, int cnt)
+{
+  return syscall2 (SYS_THREADSTAT, stats, cnt);
+}
+
+void
+tracedump (void)
+{
+  syscall0 (SYS_TRACEDUMP);
+}
+
+/* 새 스레드가 처음 실행하는 함수. FUNCTION이 반환하면 스레드를 종료한다. */
+static void
+thread_start (void (*function) (void *), void *aux)
+{
+  function (aux);
+  thread_exit ();
+}
+
+tid_t
+thread_create (void (*function) (void *), void *aux)
+{
+  return syscall3 (SYS_THREAD_CREATE, thread_start, function, aux);
+}
+
+int
+thread_join (tid_t tid)
+{
+  return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+thread_exit (void)
+{
+  syscall0 (SYS_THREAD_EXIT);
+  NOT_REACHED ();
+}
+
+int
+futex_wait (int *addr, int val)
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, val);
+}
+
+int
+futex_wake (int *addr, int cnt)
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, cnt);
+}
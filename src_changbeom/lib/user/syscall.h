@@ -3,11 +3,16 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <thread-stat.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -45,4 +50,16 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Scheduling. */
+int nice (int increment);
+int threadstat (struct thread_stat *, int cnt);
+void tracedump (void);
+
+/* User threads. */
+tid_t thread_create (void (*function) (void *), void *aux);
+int thread_join (tid_t);
+void thread_exit (void) NO_RETURN;
+int futex_wait (int *addr, int val);
+int futex_wake (int *addr, int cnt);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,85 @@
+/* Creates 1,000 threads, each of which sleeps a random number
+   of ticks.  Verifies that no thread wakes up before its
+   wake-up tick and that every thread wakes up, and reports how
+   long the timer interrupt handler took while they slept. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 1000         /* Number of sleeping threads. */
+#define MAX_SLEEP 200           /* Maximum sleep duration, in ticks. */
+
+static thread_func sleeper;
+static struct semaphore done_sema;
+static struct lock result_lock;
+static int early_cnt;           /* # of threads that woke up early. */
+static int64_t max_late;        /* Largest # of ticks late. */
+
+void
+test_alarm_stress (void) 
+{
+  uint64_t max_cycles, avg_cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating %d threads to sleep up to %d ticks each.",
+       THREAD_CNT, MAX_SLEEP);
+
+  sema_init (&done_sema, 0);
+  lock_init (&result_lock);
+  early_cnt = 0;
+  max_late = 0;
+  timer_irq_stats_reset ();
+
+  /* The sleepers have higher priority than us, so each one runs
+     and goes to sleep as soon as it is created. */
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT + 1, sleeper, NULL) == TID_ERROR)
+        fail ("couldn't create thread %d", i);
+    }
+
+  /* Wait for every sleeper to wake up. */
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done_sema);
+
+  timer_irq_stats (&max_cycles, &avg_cycles);
+  msg ("timer interrupt: max %llu cycles, avg %llu cycles",
+       max_cycles, avg_cycles);
+  msg ("latest wake-up was %lld ticks late", max_late);
+
+  if (early_cnt != 0)
+    fail ("%d threads woke up early", early_cnt);
+  pass ();
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *aux UNUSED) 
+{
+  int64_t duration = random_ulong () % MAX_SLEEP + 1;
+  int64_t wake_time = timer_ticks () + duration;
+  int64_t late;
+
+  timer_sleep (wake_time - timer_ticks ());
+  late = timer_ticks () - wake_time;
+
+  lock_acquire (&result_lock);
+  if (late < 0)
+    early_cnt++;
+  else if (late > max_late)
+    max_late = late;
+  lock_release (&result_lock);
+
+  sema_up (&done_sema);
+}
@@ -0,0 +1,157 @@
+/* Checks the word-at-a-time bitmap functions against a
+   bit-at-a-time reference and measures how fast they find free
+   bits in a nearly full 1M-bit map.
+
+   Random small bitmaps are compared with the reference for
+   bitmap_scan() and bitmap_count(), with and without a summary.
+   Then a 1M-bit map is filled except for a few single free bits
+   and one free run of 8 bits near the end, and bitmap_scan() is
+   timed for runs of 1 and 8 false bits using the reference, the
+   word-at-a-time scan, and the word-at-a-time scan with a
+   summary. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+#define BENCH_BITS (1024 * 1024)
+#define BENCH_RUN (BENCH_BITS - 100)
+#define BENCH_REPEAT 4
+#define CHECK_ROUNDS 200
+
+static size_t naive_scan (const struct bitmap *, size_t start, size_t cnt,
+                          bool value);
+static void check_random (bool summary);
+static struct bitmap *make_bench_map (void);
+static uint64_t time_scan (const struct bitmap *, size_t cnt, bool naive,
+                           size_t expected);
+
+void
+test_bitmap_scan (void)
+{
+  static const size_t cnts[2] = {1, 8};
+  static const size_t expected[2] = {BENCH_BITS / 16 - 1, BENCH_RUN};
+  int i;
+
+  random_init (0x5ca4);
+  check_random (false);
+  check_random (true);
+  msg ("scan results match the bit-at-a-time scan");
+
+  for (i = 0; i < 2; i++)
+    {
+      struct bitmap *b = make_bench_map ();
+      uint64_t naive, word, summary;
+
+      naive = time_scan (b, cnts[i], true, expected[i]);
+      word = time_scan (b, cnts[i], false, expected[i]);
+      if (!bitmap_add_summary (b))
+        fail ("out of memory");
+      summary = time_scan (b, cnts[i], false, expected[i]);
+      bitmap_destroy (b);
+
+      msg ("%d-bit map, run of %zu: bit-at-a-time %llu cycles, "
+           "word-at-a-time %llu cycles, summary %llu cycles",
+           BENCH_BITS, cnts[i], naive, word, summary);
+    }
+  pass ();
+}
+
+/* Returns a new BENCH_BITS-bit map in which only 15 single bits,
+   spread evenly, and the 8 bits starting at BENCH_RUN are false. */
+static struct bitmap *
+make_bench_map (void)
+{
+  struct bitmap *b = bitmap_create (BENCH_BITS);
+  size_t i;
+
+  if (b == NULL)
+    fail ("out of memory");
+  bitmap_set_all (b, true);
+  for (i = 1; i < 16; i++)
+    bitmap_reset (b, i * (BENCH_BITS / 16) - 1);
+  bitmap_set_multiple (b, BENCH_RUN, 8, false);
+  return b;
+}
+
+/* Finds CNT consecutive VALUE bits in B at or after START one
+   bit at a time, the way bitmap_scan() used to. */
+static size_t
+naive_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= bitmap_size (b); i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Compares bitmap_scan() and bitmap_count() with the reference on
+   random bitmaps, with a summary if SUMMARY is true. */
+static void
+check_random (bool summary)
+{
+  int round;
+
+  for (round = 0; round < CHECK_ROUNDS; round++)
+    {
+      size_t bit_cnt = random_ulong () % 300 + 1;
+      unsigned density = random_ulong () % 100;
+      struct bitmap *b = bitmap_create (bit_cnt);
+      size_t i, start, cnt, count;
+      bool value = random_ulong () % 2;
+
+      if (b == NULL || (summary && !bitmap_add_summary (b)))
+        fail ("out of memory");
+      for (i = 0; i < bit_cnt; i++)
+        if (random_ulong () % 100 < density)
+          bitmap_mark (b, i);
+
+      start = random_ulong () % (bit_cnt + 1);
+      cnt = random_ulong () % 10;
+      if (bitmap_scan (b, start, cnt, value)
+          != naive_scan (b, start, cnt, value))
+        fail ("bitmap_scan (%zu, %zu, %d) on %zu bits: got %zu, expected %zu",
+              start, cnt, value, bit_cnt, bitmap_scan (b, start, cnt, value),
+              naive_scan (b, start, cnt, value));
+
+      cnt = random_ulong () % (bit_cnt - start + 1);
+      count = 0;
+      for (i = start; i < start + cnt; i++)
+        if (bitmap_test (b, i) == value)
+          count++;
+      if (bitmap_count (b, start, cnt, value) != count)
+        fail ("bitmap_count (%zu, %zu, %d): got %zu, expected %zu",
+              start, cnt, value, bitmap_count (b, start, cnt, value), count);
+      bitmap_destroy (b);
+    }
+}
+
+/* Returns the average number of cycles that a scan of B for CNT
+   false bits takes, using the reference if NAIVE is true.  Fails
+   unless the scan returns EXPECTED. */
+static uint64_t
+time_scan (const struct bitmap *b, size_t cnt, bool naive, size_t expected)
+{
+  uint64_t start = timer_tsc ();
+  int i;
+
+  for (i = 0; i < BENCH_REPEAT; i++)
+    {
+      size_t idx = naive ? naive_scan (b, 0, cnt, false)
+                         : bitmap_scan (b, 0, cnt, false);
+      if (idx != expected)
+        fail ("scan for %zu free bits returned %zu, expected %zu",
+              cnt, idx, expected);
+    }
+  return (timer_tsc () - start) / BENCH_REPEAT;
+}
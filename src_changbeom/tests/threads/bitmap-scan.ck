@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "scan results did not match the reference"
+  unless grep (/scan results match the bit-at-a-time scan/, @output);
+foreach my $cnt (1, 8) {
+  fail "missing timings for runs of $cnt"
+    unless grep (/run of $cnt: bit-at-a-time \d+ cycles/, @output);
+}
+fail "missing PASS in output"
+  unless grep ($_ eq '(bitmap-scan) PASS', @output);
+
+pass;
@@ -0,0 +1,66 @@
+/* Checks admission control for periodic threads.
+
+   Periodic threads are admitted as long as their total CPU
+   utilization stays within the limit of 95%, invalid periods and
+   budgets are rejected, and the utilization of a periodic thread
+   is given back when it exits. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func periodic_thread;
+static void try_create (int64_t period, int64_t budget);
+
+static struct semaphore release, exited;
+static int created;
+
+void
+test_edf_admit (void)
+{
+  sema_init (&release, 0);
+  sema_init (&exited, 0);
+  created = 0;
+
+  try_create (10, 5);
+  try_create (10, 4);
+  try_create (10, 1);
+  try_create (100, 5);
+  try_create (100, 1);
+  try_create (0, 0);
+  try_create (10, 11);
+
+  /* Let the admitted threads exit. */
+  while (created > 0)
+    {
+      sema_up (&release);
+      sema_down (&exited);
+      created--;
+    }
+
+  try_create (10, 9);
+  sema_up (&release);
+  sema_down (&exited);
+}
+
+/* Tries to create a periodic thread and reports the result. */
+static void
+try_create (int64_t period, int64_t budget)
+{
+  tid_t tid = thread_create_periodic ("periodic", period, budget,
+                                      periodic_thread, NULL);
+
+  msg ("period %lld, budget %lld: %s.", period, budget,
+       tid != TID_ERROR ? "admitted" : "rejected");
+  if (tid != TID_ERROR)
+    created++;
+}
+
+static void
+periodic_thread (void *aux UNUSED)
+{
+  sema_down (&release);
+  sema_up (&exited);
+}
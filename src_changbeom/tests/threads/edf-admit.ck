@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admit) begin
+(edf-admit) period 10, budget 5: admitted.
+(edf-admit) period 10, budget 4: admitted.
+(edf-admit) period 10, budget 1: rejected.
+(edf-admit) period 100, budget 5: admitted.
+(edf-admit) period 100, budget 1: rejected.
+(edf-admit) period 0, budget 0: rejected.
+(edf-admit) period 10, budget 11: rejected.
+(edf-admit) period 10, budget 9: admitted.
+(edf-admit) end
+EOF
+pass;
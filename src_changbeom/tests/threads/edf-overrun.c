@@ -0,0 +1,97 @@
+/* Checks that a periodic thread is stopped when it runs out of
+   budget, and that the jobs it could not finish in time are
+   counted as deadline misses.
+
+   The periodic thread has a budget of 2 ticks every 10 ticks,
+   but each of its 3 jobs needs 5 ticks of CPU time.  So every
+   job is stopped twice, misses two deadlines and finishes in its
+   third period.  A CPU-bound thread at PRI_MAX must get the CPU
+   while the periodic thread is stopped. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define JOB_CNT 3
+#define JOB_WORK 5
+
+struct overrun_info
+  {
+    unsigned jobs, misses, overruns;
+    struct semaphore done;
+  };
+
+static thread_func overrun_thread;
+static thread_func hog_thread;
+
+static volatile bool periodic_done;
+static volatile int64_t hog_ticks;
+
+void
+test_edf_overrun (void)
+{
+  struct overrun_info info;
+  struct semaphore hog_exit;
+
+  thread_set_priority (PRI_MAX);
+  sema_init (&info.done, 0);
+  sema_init (&hog_exit, 0);
+
+  periodic_done = false;
+  hog_ticks = 0;
+  thread_create ("hog", PRI_MAX, hog_thread, &hog_exit);
+  if (thread_create_periodic ("overrun", 10, 2, overrun_thread, &info)
+      == TID_ERROR)
+    fail ("thread_create_periodic() failed");
+
+  sema_down (&info.done);
+  periodic_done = true;
+  sema_down (&hog_exit);
+
+  msg ("overrun: %u jobs, %u deadline misses, %u overruns.",
+       info.jobs, info.misses, info.overruns);
+  if (hog_ticks > 0)
+    msg ("The CPU-bound thread ran while the periodic thread was stopped.");
+  else
+    fail ("The CPU-bound thread never ran.");
+}
+
+static void
+overrun_thread (void *info_)
+{
+  struct overrun_info *info = info_;
+  struct thread *t = thread_current ();
+  int i;
+
+  for (i = 0; i < JOB_CNT; i++)
+    {
+      int64_t start = t->run_ticks;
+      while (t->run_ticks - start < JOB_WORK)
+        continue;
+      thread_wait_period ();
+    }
+
+  info->jobs = t->edf_jobs;
+  info->misses = t->edf_misses;
+  info->overruns = t->edf_overruns;
+  sema_up (&info->done);
+}
+
+static void
+hog_thread (void *exit_)
+{
+  struct semaphore *exit = exit_;
+  int64_t last = timer_ticks ();
+
+  while (!periodic_done)
+    {
+      int64_t now = timer_ticks ();
+      if (now != last)
+        hog_ticks++;
+      last = now;
+    }
+  sema_up (exit);
+}
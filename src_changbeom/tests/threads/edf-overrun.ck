@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-overrun) begin
+(edf-overrun) overrun: 3 jobs, 6 deadline misses, 6 overruns.
+(edf-overrun) The CPU-bound thread ran while the periodic thread was stopped.
+(edf-overrun) end
+EOF
+pass;
@@ -0,0 +1,113 @@
+/* Checks that periodic threads meet their deadlines while
+   higher-priority threads keep the CPU busy.
+
+   Three periodic threads with a total utilization of about 78%
+   each run ten jobs, and every job uses one tick less than its
+   budget.  Two CPU-bound threads at PRI_MAX run at the same
+   time, but the EDF class sits above every priority, so no job
+   may miss its deadline or run out of budget. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define PERIODIC_CNT 3
+#define HOG_CNT 2
+#define JOB_CNT 10
+
+struct periodic_info
+  {
+    int64_t period;             /* Period, in ticks. */
+    int64_t budget;             /* Budget per period, in ticks. */
+    int64_t work;               /* Ticks of CPU time used per job. */
+    unsigned jobs, misses, overruns;
+    struct semaphore *done;
+  };
+
+static thread_func periodic_thread;
+static thread_func hog_thread;
+
+static volatile bool hogs_done;
+
+void
+test_edf_periodic (void)
+{
+  static const int64_t periods[PERIODIC_CNT] = {10, 20, 40};
+  static const int64_t budgets[PERIODIC_CNT] = {3, 5, 9};
+  struct periodic_info info[PERIODIC_CNT];
+  struct semaphore done, hog_exit;
+  int i;
+
+  /* Run round-robin with the hogs so we can stop them. */
+  thread_set_priority (PRI_MAX);
+  sema_init (&done, 0);
+  sema_init (&hog_exit, 0);
+
+  hogs_done = false;
+  for (i = 0; i < HOG_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "hog %d", i);
+      thread_create (name, PRI_MAX, hog_thread, &hog_exit);
+    }
+
+  for (i = 0; i < PERIODIC_CNT; i++)
+    {
+      struct periodic_info *pi = &info[i];
+      char name[16];
+
+      pi->period = periods[i];
+      pi->budget = budgets[i];
+      pi->work = budgets[i] - 1;
+      pi->done = &done;
+
+      snprintf (name, sizeof name, "periodic %d", i);
+      if (thread_create_periodic (name, pi->period, pi->budget,
+                                  periodic_thread, pi) == TID_ERROR)
+        fail ("thread_create_periodic() rejected %s", name);
+    }
+
+  for (i = 0; i < PERIODIC_CNT; i++)
+    sema_down (&done);
+  hogs_done = true;
+  for (i = 0; i < HOG_CNT; i++)
+    sema_down (&hog_exit);
+
+  for (i = 0; i < PERIODIC_CNT; i++)
+    msg ("periodic %d: %u jobs, %u deadline misses, %u overruns.",
+         i, info[i].jobs, info[i].misses, info[i].overruns);
+}
+
+static void
+periodic_thread (void *pi_)
+{
+  struct periodic_info *pi = pi_;
+  struct thread *t = thread_current ();
+  int i;
+
+  for (i = 0; i < JOB_CNT; i++)
+    {
+      int64_t start = t->run_ticks;
+      while (t->run_ticks - start < pi->work)
+        continue;
+      thread_wait_period ();
+    }
+
+  pi->jobs = t->edf_jobs;
+  pi->misses = t->edf_misses;
+  pi->overruns = t->edf_overruns;
+  sema_up (pi->done);
+}
+
+static void
+hog_thread (void *exit_)
+{
+  struct semaphore *exit = exit_;
+
+  while (!hogs_done)
+    continue;
+  sema_up (exit);
+}
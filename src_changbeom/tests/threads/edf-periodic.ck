@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-periodic) begin
+(edf-periodic) periodic 0: 10 jobs, 0 deadline misses, 0 overruns.
+(edf-periodic) periodic 1: 10 jobs, 0 deadline misses, 0 overruns.
+(edf-periodic) periodic 2: 10 jobs, 0 deadline misses, 0 overruns.
+(edf-periodic) end
+EOF
+pass;
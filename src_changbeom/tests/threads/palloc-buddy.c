@@ -0,0 +1,108 @@
+/* Checks the buddy allocator behind palloc_get_multiple().
+
+   Allocates blocks of mixed sizes from the user pool and checks
+   that each takes exactly as many pages as requested, then frees
+   them in a different order and checks that the free pages have
+   coalesced back into the same blocks as before.  Finally takes
+   every free page one at a time and gives them all back. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define BLOCK_CNT 10
+
+static void check_same (const struct palloc_stats *,
+                        const struct palloc_stats *);
+
+void
+test_palloc_buddy (void)
+{
+  static const size_t sizes[BLOCK_CNT] = {1, 3, 2, 5, 1, 4, 8, 7, 1, 2};
+  static const int free_order[BLOCK_CNT] = {4, 0, 7, 2, 9, 5, 1, 8, 3, 6};
+  struct palloc_stats start, stats;
+  uint8_t *blocks[BLOCK_CNT];
+  void *head;
+  size_t free_pages, page_cnt;
+  int i;
+
+  palloc_get_stats (PAL_USER, &start);
+  if (start.free_pages != start.page_cnt)
+    fail ("user pool has %zu pages in use before the test",
+          start.page_cnt - start.free_pages);
+
+  msg ("allocate blocks of mixed sizes");
+  free_pages = start.free_pages;
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      blocks[i] = palloc_get_multiple (PAL_USER, sizes[i]);
+      if (blocks[i] == NULL)
+        fail ("allocating %zu pages failed", sizes[i]);
+      memset (blocks[i], i, sizes[i] * PGSIZE);
+
+      palloc_get_stats (PAL_USER, &stats);
+      if (stats.free_pages != free_pages - sizes[i])
+        fail ("allocating %zu pages took %zu pages",
+              sizes[i], free_pages - stats.free_pages);
+      free_pages = stats.free_pages;
+    }
+
+  msg ("check that blocks do not overlap");
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      size_t j;
+
+      for (j = 0; j < sizes[i] * PGSIZE; j++)
+        if (blocks[i][j] != i)
+          fail ("block %d was overwritten", i);
+    }
+
+  msg ("free blocks in a different order");
+  for (i = 0; i < BLOCK_CNT; i++)
+    palloc_free_multiple (blocks[free_order[i]], sizes[free_order[i]]);
+  palloc_get_stats (PAL_USER, &stats);
+  check_same (&start, &stats);
+
+  msg ("allocate every free page one at a time");
+  head = NULL;
+  page_cnt = 0;
+  for (;;)
+    {
+      void **page = palloc_get_page (PAL_USER);
+      if (page == NULL)
+        break;
+      *page = head;
+      head = page;
+      page_cnt++;
+    }
+  if (page_cnt != start.free_pages)
+    fail ("got %zu pages, expected %zu", page_cnt, start.free_pages);
+
+  msg ("free every page");
+  while (head != NULL)
+    {
+      void **page = head;
+      head = *page;
+      palloc_free_page (page);
+    }
+  palloc_get_stats (PAL_USER, &stats);
+  check_same (&start, &stats);
+}
+
+/* Fails unless A and B describe the same free blocks. */
+static void
+check_same (const struct palloc_stats *a, const struct palloc_stats *b)
+{
+  int order;
+
+  if (a->free_pages != b->free_pages)
+    fail ("%zu pages free, expected %zu", b->free_pages, a->free_pages);
+  for (order = 0; order < PALLOC_ORDER_CNT; order++)
+    if (a->free_blocks[order] != b->free_blocks[order])
+      fail ("%zu free blocks of order %d, expected %zu",
+            b->free_blocks[order], order, a->free_blocks[order]);
+  msg ("free pages coalesced");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) allocate blocks of mixed sizes
+(palloc-buddy) check that blocks do not overlap
+(palloc-buddy) free blocks in a different order
+(palloc-buddy) free pages coalesced
+(palloc-buddy) allocate every free page one at a time
+(palloc-buddy) free every page
+(palloc-buddy) free pages coalesced
+(palloc-buddy) end
+EOF
+pass;
@@ -0,0 +1,116 @@
+/* Checks that the idle thread zeroes free pages in the
+   background, so that PAL_ZERO allocations find them already
+   zeroed.
+
+   Sleeps so that the idle thread can zero the user pool, then
+   allocates pages with PAL_ZERO and checks that they are all
+   zeros and were counted as pre-zeroed.  Dirties and frees them,
+   and checks that after another sleep they are zeroed again.
+   Finally dirties and frees them once more and allocates again
+   right away, checking that PAL_ZERO skips the just-freed dirty
+   pages in favor of pages that are already zeroed. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define PAGE_CNT 8
+
+static void wait_for_zeroing (void);
+static void alloc_zeroed (uint8_t *pages[PAGE_CNT]);
+static void dirty_and_free (uint8_t *pages[PAGE_CNT]);
+
+void
+test_palloc_zero (void)
+{
+  uint8_t *pages[PAGE_CNT];
+  int i;
+
+  wait_for_zeroing ();
+  msg ("allocate %d pre-zeroed pages", PAGE_CNT);
+  alloc_zeroed (pages);
+
+  msg ("dirty and free them");
+  dirty_and_free (pages);
+
+  wait_for_zeroing ();
+  msg ("allocate them again");
+  alloc_zeroed (pages);
+
+  msg ("dirty and free them again");
+  dirty_and_free (pages);
+
+  msg ("allocate right away");
+  alloc_zeroed (pages);
+  for (i = 0; i < PAGE_CNT; i++)
+    palloc_free_page (pages[i]);
+}
+
+/* Fills the PAGE_CNT pages in PAGES with nonzero bytes, frees
+   them, and checks that they are counted as needing zeroing. */
+static void
+dirty_and_free (uint8_t *pages[PAGE_CNT])
+{
+  struct palloc_stats stats;
+  int i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    memset (pages[i], 0x5a, PGSIZE);
+  for (i = 0; i < PAGE_CNT; i++)
+    palloc_free_page (pages[i]);
+  palloc_get_stats (PAL_USER, &stats);
+  if (stats.dirty_pages < PAGE_CNT)
+    fail ("only %zu free pages need zeroing", stats.dirty_pages);
+}
+
+/* Sleeps until the idle thread has zeroed every free page in
+   the user pool, failing if that takes more than 5 seconds. */
+static void
+wait_for_zeroing (void)
+{
+  struct palloc_stats stats;
+  int i;
+
+  for (i = 0; i < 50; i++)
+    {
+      timer_msleep (100);
+      palloc_get_stats (PAL_USER, &stats);
+      if (stats.dirty_pages == 0)
+        {
+          msg ("idle thread zeroed the free pages");
+          return;
+        }
+    }
+  fail ("%zu free pages still not zeroed", stats.dirty_pages);
+}
+
+/* Allocates PAGE_CNT user pages with PAL_ZERO into PAGES and
+   checks that they are zeros and were all pre-zeroed. */
+static void
+alloc_zeroed (uint8_t *pages[PAGE_CNT])
+{
+  struct palloc_stats before, after;
+  int i;
+  size_t j;
+
+  palloc_get_stats (PAL_USER, &before);
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      pages[i] = palloc_get_page (PAL_USER | PAL_ZERO);
+      if (pages[i] == NULL)
+        fail ("out of user pages");
+      for (j = 0; j < PGSIZE; j++)
+        if (pages[i][j] != 0)
+          fail ("byte %zu of page %d is %#x", j, i, pages[i][j]);
+    }
+  palloc_get_stats (PAL_USER, &after);
+  if (after.zero_allocs - before.zero_allocs != PAGE_CNT
+      || after.zero_hits - before.zero_hits != PAGE_CNT)
+    fail ("%zu of %zu PAL_ZERO pages were pre-zeroed",
+          after.zero_hits - before.zero_hits,
+          after.zero_allocs - before.zero_allocs);
+}
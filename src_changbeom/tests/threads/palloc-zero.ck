@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-zero) begin
+(palloc-zero) idle thread zeroed the free pages
+(palloc-zero) allocate 8 pre-zeroed pages
+(palloc-zero) dirty and free them
+(palloc-zero) idle thread zeroed the free pages
+(palloc-zero) allocate them again
+(palloc-zero) dirty and free them again
+(palloc-zero) allocate right away
+(palloc-zero) end
+EOF
+pass;
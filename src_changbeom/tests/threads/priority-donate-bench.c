@@ -0,0 +1,110 @@
+/* Builds a chain of 8 nested locks and has 64 threads of
+   increasing priority contend on them, so that every
+   lock_acquire() donates through the whole chain.  Verifies
+   that the main thread ends up with the highest donated
+   priority and gets its own priority back, and reports how
+   many cycles the donation and release phases took. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define LOCK_CNT 8              /* Number of nested locks. */
+#define WAITER_CNT 64           /* Number of contending threads. */
+
+static thread_func holder_thread;
+static thread_func waiter_thread;
+static struct lock locks[LOCK_CNT];
+static struct semaphore done_sema;
+
+void
+test_priority_donate_bench (void) 
+{
+  uint64_t start, donate_cycles, release_cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&done_sema, 0);
+  for (i = 0; i < LOCK_CNT; i++)
+    lock_init (&locks[i]);
+  lock_acquire (&locks[0]);
+
+  /* Holder I takes lock I and then waits on lock I - 1, so the
+     locks form a chain that ends at us. */
+  for (i = 1; i < LOCK_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "holder %d", i);
+      thread_create (name, PRI_DEFAULT + 1, holder_thread, &locks[i]);
+      thread_yield ();
+    }
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+
+  /* Each waiter has at least our donated priority, so it runs
+     and blocks on its lock as soon as we yield to it. */
+  start = timer_tsc ();
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i * (PRI_MAX - PRI_DEFAULT) / WAITER_CNT,
+                     waiter_thread, &locks[i % LOCK_CNT]);
+      thread_yield ();
+    }
+  donate_cycles = timer_tsc () - start;
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_MAX, thread_get_priority ());
+
+  /* Every other thread has a higher priority than our own, so
+     they all finish before lock_release() returns. */
+  start = timer_tsc ();
+  lock_release (&locks[0]);
+  release_cycles = timer_tsc () - start;
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  for (i = 0; i < LOCK_CNT - 1 + WAITER_CNT; i++)
+    sema_down (&done_sema);
+
+  msg ("donation: %llu cycles (%llu per waiter)",
+       donate_cycles, donate_cycles / WAITER_CNT);
+  msg ("release: %llu cycles", release_cycles);
+
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("priority was not restored");
+  pass ();
+}
+
+/* Takes lock AUX, then blocks on the lock just before it in the
+   chain. */
+static void
+holder_thread (void *aux) 
+{
+  struct lock *lock = aux;
+
+  lock_acquire (lock);
+  lock_acquire (lock - 1);
+  lock_release (lock - 1);
+  lock_release (lock);
+  sema_up (&done_sema);
+}
+
+/* Contends on lock AUX. */
+static void
+waiter_thread (void *aux) 
+{
+  struct lock *lock = aux;
+
+  lock_acquire (lock);
+  lock_release (lock);
+  sema_up (&done_sema);
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+foreach my $pri (32, 63, 31) {
+  fail "main thread did not have priority $pri"
+    unless grep (/should have priority $pri\.  Actual priority: $pri\./,
+                 @output);
+}
+fail "missing PASS in output"
+  unless grep ($_ eq '(priority-donate-bench) PASS', @output);
+
+pass;
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+my ($name) = $test =~ m%([^/]+)$%;
+fail "missing thread report"
+  unless grep (/^\($name\) Thread 3 .* received \d+ ticks/, @output);
+fail "missing fairness index"
+  unless grep (/^\($name\) Fairness index: \d+\.\d+\./, @output);
+
+pass;
@@ -0,0 +1,150 @@
+/* Measures how CPU time is shared among CPU-bound threads.
+
+   Four threads spin for 10 seconds: one at priority
+   PRI_DEFAULT + 1 and three at PRI_DEFAULT, one of which has
+   nice 5.  The fair share of each thread is proportional to the
+   weight that the fair-share scheduler gives its nice value, so
+   the first three threads should each get about 32% of the CPU
+   and the last about 10%.
+
+   sched-fair-rr runs with the default priority round-robin
+   scheduler, where the higher-priority thread starves the
+   others.  sched-fair-cfs runs with "-cfs", where priorities
+   are ignored and every thread must receive some CPU time.
+
+   Each test reports the ticks every thread received and Jain's
+   fairness index of the weight-normalized shares, which is 1.000
+   when every thread gets exactly its fair share. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 4
+#define SPIN_SECONDS 10
+
+struct thread_info
+  {
+    int priority;
+    int nice;
+    int weight;                 /* Fair-share weight of NICE. */
+    int64_t start_time;
+    int tick_count;
+    struct semaphore *done;
+  };
+
+static void test_sched_fair (void);
+static thread_func load_thread;
+
+void
+test_sched_fair_rr (void)
+{
+  ASSERT (!thread_mlfqs && !thread_cfs);
+  test_sched_fair ();
+}
+
+void
+test_sched_fair_cfs (void)
+{
+  ASSERT (thread_cfs);
+  test_sched_fair ();
+}
+
+static void
+test_sched_fair (void)
+{
+  static const int priorities[THREAD_CNT] =
+    {PRI_DEFAULT + 1, PRI_DEFAULT, PRI_DEFAULT, PRI_DEFAULT};
+  static const int nices[THREAD_CNT] = {0, 0, 0, 5};
+  static const int weights[THREAD_CNT] = {1024, 1024, 1024, 335};
+  struct thread_info info[THREAD_CNT];
+  struct semaphore done;
+  int64_t start_time, total_ticks, sum_x, sum_x2;
+  int total_weight;
+  int i;
+
+  /* Make sure we can wake up to start the threads and report. */
+  thread_set_priority (PRI_MAX);
+  sema_init (&done, 0);
+
+  total_weight = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    total_weight += weights[i];
+
+  start_time = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->priority = priorities[i];
+      ti->nice = nices[i];
+      ti->weight = weights[i];
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->done = &done;
+
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, ti->priority, load_thread, ti);
+    }
+
+  msg ("Letting threads run for %d seconds, please wait...",
+       SPIN_SECONDS + 1);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  total_ticks = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    total_ticks += info[i].tick_count;
+
+  /* Jain's index (sum x)^2 / (n * sum x^2) over x = ticks / weight. */
+  sum_x = sum_x2 = 0;
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      int64_t x = (int64_t) ti->tick_count * 1024 / ti->weight;
+
+      msg ("Thread %d (priority %d, nice %d) received %d ticks, "
+           "fair share %"PRId64".",
+           i, ti->priority, ti->nice, ti->tick_count,
+           total_ticks * ti->weight / total_weight);
+      sum_x += x;
+      sum_x2 += x * x;
+    }
+  if (sum_x2 > 0)
+    {
+      int64_t index = sum_x * sum_x * 1000 / (THREAD_CNT * sum_x2);
+      msg ("Fairness index: %"PRId64".%03"PRId64".",
+           index / 1000, index % 1000);
+    }
+
+  if (thread_cfs)
+    for (i = 0; i < THREAD_CNT; i++)
+      if (info[i].tick_count == 0)
+        fail ("Thread %d was starved.", i);
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 1 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + SPIN_SECONDS * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  /* Start spinning at the same time as the other threads. */
+  thread_set_nice (ti->nice);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+  sema_up (ti->done);
+}
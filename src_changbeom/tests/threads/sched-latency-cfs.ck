@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+my ($name) = $test =~ m%([^/]+)$%;
+fail "missing latency report"
+  unless grep (/^\($name\) Wakeup latency over \d+ sleeps: average \d+ us, maximum \d+ us\./,
+               @output);
+
+pass;
@@ -0,0 +1,94 @@
+/* Measures how quickly a thread that sleeps for short periods
+   gets the CPU back while CPU-bound threads of the same priority
+   keep the CPU busy.
+
+   The main thread sleeps for 5 ms twenty times while three
+   threads spin, and reports the average and maximum delay
+   between each wakeup deadline and the moment it runs again.
+
+   sched-latency-rr runs with the default priority round-robin
+   scheduler, where the woken thread waits behind the spinning
+   threads' time slices.  sched-latency-cfs runs with "-cfs",
+   where the woken thread's sleeper credit lets it preempt the
+   spinning threads right away. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SPINNER_CNT 3
+#define ITER_CNT 20
+#define SLEEP_NS (5 * 1000 * 1000)
+
+static void test_sched_latency (void);
+static thread_func spin_thread;
+
+static volatile bool done;
+static struct semaphore exit_sema;
+
+void
+test_sched_latency_rr (void)
+{
+  ASSERT (!thread_mlfqs && !thread_cfs);
+  test_sched_latency ();
+}
+
+void
+test_sched_latency_cfs (void)
+{
+  ASSERT (thread_cfs);
+  test_sched_latency ();
+}
+
+static void
+test_sched_latency (void)
+{
+  int64_t total = 0, max = 0;
+  int i;
+
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  done = false;
+  sema_init (&exit_sema, 0);
+  for (i = 0; i < SPINNER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "spin %d", i);
+      thread_create (name, PRI_DEFAULT, spin_thread, NULL);
+    }
+
+  /* Let the spinning threads use up some CPU time first. */
+  timer_sleep (TIMER_FREQ / 2);
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      int64_t deadline = timer_ns () + SLEEP_NS;
+      int64_t latency;
+
+      timer_sleep_until_ns (deadline);
+      latency = timer_ns () - deadline;
+      total += latency;
+      if (latency > max)
+        max = latency;
+    }
+
+  done = true;
+  for (i = 0; i < SPINNER_CNT; i++)
+    sema_down (&exit_sema);
+
+  msg ("Wakeup latency over %d sleeps: average %"PRId64" us, "
+       "maximum %"PRId64" us.",
+       ITER_CNT, total / ITER_CNT / 1000, max / 1000);
+}
+
+static void
+spin_thread (void *aux UNUSED)
+{
+  while (!done)
+    continue;
+  sema_up (&exit_sema);
+}
@@ -0,0 +1,96 @@
+/* Checks kmem_cache allocation, constructors and the magazine.
+
+   Allocates enough 40-byte objects to fill several slabs and
+   checks that each object was constructed and that they do not
+   overlap.  After all of them are freed, no object may be in
+   use and the emptied slabs must have gone back to palloc.
+   Objects allocated again come from the magazine first and must
+   still hold the state their constructor gave them. */
+
+#include <stdio.h>
+#include <round.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/slab.h"
+
+#define OBJ_CNT 300
+#define OBJ_MAGIC 0x0b1ec7
+
+struct obj
+  {
+    unsigned magic;             /* Set by the constructor. */
+    int value;
+    char pad[32];
+  };
+
+static void obj_ctor (void *);
+
+void
+test_slab_cache (void)
+{
+  static struct obj *objs[OBJ_CNT];
+  struct kmem_cache *cache;
+  struct kmem_cache_stats stats;
+  size_t peak_slabs, hits;
+  int i;
+
+  cache = kmem_cache_create ("test", sizeof (struct obj), obj_ctor);
+  if (cache == NULL)
+    fail ("kmem_cache_create failed");
+  kmem_cache_get_stats (cache, &stats);
+  if (stats.obj_size != sizeof (struct obj))
+    fail ("object size %zu, expected %zu", stats.obj_size, sizeof (struct obj));
+
+  msg ("allocate %d objects", OBJ_CNT);
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL)
+        fail ("allocation %d failed", i);
+      if (objs[i]->magic != OBJ_MAGIC)
+        fail ("object %d was not constructed", i);
+      objs[i]->value = i;
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    if (objs[i]->value != i)
+      fail ("object %d was overwritten", i);
+
+  kmem_cache_get_stats (cache, &stats);
+  if (stats.active != OBJ_CNT)
+    fail ("%zu objects in use, expected %d", stats.active, OBJ_CNT);
+  if (stats.slab_cnt != DIV_ROUND_UP (OBJ_CNT, stats.objs_per_slab))
+    fail ("%zu slabs for %d objects of %zu per slab",
+          stats.slab_cnt, OBJ_CNT, stats.objs_per_slab);
+  peak_slabs = stats.slab_cnt;
+
+  msg ("free all objects");
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (cache, objs[i]);
+  kmem_cache_get_stats (cache, &stats);
+  if (stats.active != 0)
+    fail ("%zu objects still in use", stats.active);
+  if (stats.slab_cnt >= peak_slabs)
+    fail ("%zu slabs left after freeing everything", stats.slab_cnt);
+
+  msg ("allocate again from the magazine");
+  hits = stats.mag_hits;
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL || objs[i]->magic != OBJ_MAGIC)
+        fail ("reallocated object %d lost its constructed state", i);
+    }
+  kmem_cache_get_stats (cache, &stats);
+  if (stats.mag_hits == hits)
+    fail ("no allocation was served from the magazine");
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (cache, objs[i]);
+}
+
+static void
+obj_ctor (void *obj_)
+{
+  struct obj *obj = obj_;
+  obj->magic = OBJ_MAGIC;
+}
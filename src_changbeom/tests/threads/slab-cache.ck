@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) allocate 300 objects
+(slab-cache) free all objects
+(slab-cache) allocate again from the magazine
+(slab-cache) end
+EOF
+pass;
@@ -0,0 +1,122 @@
+/* Checks memcpy(), memmove() and memset() against byte-at-a-time
+   references at every alignment, and measures them for sizes
+   from 1 byte to 64 kB.
+
+   For each size, reports the average number of cycles that
+   memcpy(), an overlapping memmove() in each direction and
+   memset() take, next to a byte-at-a-time copy loop. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define MAX_SIZE (64 * 1024)
+#define BUF_PAGES (MAX_SIZE / PGSIZE + 1)
+#define CHECK_SIZE 96
+#define REPEAT 8
+
+static void check_alignments (uint8_t *a, uint8_t *b);
+static void byte_copy (uint8_t *dst, const uint8_t *src, size_t size);
+
+void
+test_string_bench (void)
+{
+  uint8_t *a = palloc_get_multiple (PAL_ASSERT, BUF_PAGES);
+  uint8_t *b = palloc_get_multiple (PAL_ASSERT, BUF_PAGES);
+  size_t size;
+
+  check_alignments (a, b);
+  msg ("results match the byte-at-a-time versions");
+
+  random_bytes (a, BUF_PAGES * PGSIZE);
+  for (size = 1; size <= MAX_SIZE; size *= 4)
+    {
+      uint64_t start, loop, copy, up, down, set;
+      int i;
+
+      start = timer_tsc ();
+      for (i = 0; i < REPEAT; i++)
+        byte_copy (b, a, size);
+      loop = (timer_tsc () - start) / REPEAT;
+
+      start = timer_tsc ();
+      for (i = 0; i < REPEAT; i++)
+        memcpy (b, a, size);
+      copy = (timer_tsc () - start) / REPEAT;
+
+      start = timer_tsc ();
+      for (i = 0; i < REPEAT; i++)
+        memmove (a, a + 1, size);
+      up = (timer_tsc () - start) / REPEAT;
+
+      start = timer_tsc ();
+      for (i = 0; i < REPEAT; i++)
+        memmove (a + 1, a, size);
+      down = (timer_tsc () - start) / REPEAT;
+
+      start = timer_tsc ();
+      for (i = 0; i < REPEAT; i++)
+        memset (b, i, size);
+      set = (timer_tsc () - start) / REPEAT;
+
+      msg ("%5zu bytes: byte loop %llu, memcpy %llu, memmove up %llu, "
+           "memmove down %llu, memset %llu cycles",
+           size, loop, copy, up, down, set);
+    }
+
+  palloc_free_multiple (a, BUF_PAGES);
+  palloc_free_multiple (b, BUF_PAGES);
+  pass ();
+}
+
+/* Compares each function with a byte-at-a-time reference for
+   every size up to CHECK_SIZE at every combination of source and
+   destination alignment, using A and B as scratch space. */
+static void
+check_alignments (uint8_t *a, uint8_t *b)
+{
+  static uint8_t expected[CHECK_SIZE + 8];
+  size_t size, dst, src, i;
+
+  for (size = 0; size <= CHECK_SIZE; size++)
+    for (dst = 0; dst < 4; dst++)
+      for (src = 0; src < 4; src++)
+        {
+          random_bytes (a, sizeof expected);
+          random_bytes (b, sizeof expected);
+
+          memcpy (expected, b, sizeof expected);
+          byte_copy (expected + dst, a + src, size);
+          if (memcpy (b + dst, a + src, size) != b + dst
+              || memcmp (b, expected, sizeof expected))
+            fail ("memcpy of %zu bytes from +%zu to +%zu", size, src, dst);
+
+          /* Overlapping moves in both directions within A. */
+          memcpy (expected, a, sizeof expected);
+          for (i = 0; i < size; i++)
+            expected[dst + 4 - src + i] = a[4 + i];
+          if (memmove (a + dst + 4 - src, a + 4, size) != a + dst + 4 - src
+              || memcmp (a, expected, sizeof expected))
+            fail ("memmove of %zu bytes by %d", size, (int) (dst - src));
+
+          memcpy (expected, b, sizeof expected);
+          for (i = 0; i < size; i++)
+            expected[dst + i] = (uint8_t) (size + src);
+          if (memset (b + dst, size + src, size) != b + dst
+              || memcmp (b, expected, sizeof expected))
+            fail ("memset of %zu bytes at +%zu", size, dst);
+        }
+}
+
+/* Copies SIZE bytes from SRC to DST one byte at a time. */
+static void
+byte_copy (uint8_t *dst, const uint8_t *src, size_t size)
+{
+  while (size-- > 0)
+    *dst++ = *src++;
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "results did not match the byte-at-a-time versions"
+  unless grep (/results match the byte-at-a-time versions/, @output);
+foreach my $size (1, 4, 16, 64, 256, 1024, 4096, 16384, 65536) {
+  fail "missing timings for $size bytes"
+    unless grep (/\b$size bytes: byte loop \d+, memcpy \d+/, @output);
+}
+fail "missing PASS in output"
+  unless grep ($_ eq '(string-bench) PASS', @output);
+
+pass;
@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-stress", test_alarm_stress},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,6 +26,7 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-bench", test_priority_donate_bench},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
@@ -38,6 +40,18 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"sched-fair-rr", test_sched_fair_rr},
+    {"sched-fair-cfs", test_sched_fair_cfs},
+    {"sched-latency-rr", test_sched_latency_rr},
+    {"sched-latency-cfs", test_sched_latency_cfs},
+    {"edf-periodic", test_edf_periodic},
+    {"edf-overrun", test_edf_overrun},
+    {"edf-admit", test_edf_admit},
+    {"palloc-buddy", test_palloc_buddy},
+    {"slab-cache", test_slab_cache},
+    {"bitmap-scan", test_bitmap_scan},
+    {"string-bench", test_string_bench},
+    {"palloc-zero", test_palloc_zero},
   };
 
 static const char *test_name;
@@ -11,6 +11,7 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_stress;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,6 +20,7 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_bench;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
@@ -32,6 +34,18 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_sched_fair_rr;
+extern test_func test_sched_fair_cfs;
+extern test_func test_sched_latency_rr;
+extern test_func test_sched_latency_cfs;
+extern test_func test_edf_periodic;
+extern test_func test_edf_overrun;
+extern test_func test_edf_admit;
+extern test_func test_palloc_buddy;
+extern test_func test_slab_cache;
+extern test_func test_bitmap_scan;
+extern test_func test_string_bench;
+extern test_func test_palloc_zero;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,90 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 형식의 고정 소수점 연산.
+   커널에서는 floating point 연산을 사용할 수 없으므로
+   mlfqs의 recent_cpu, load_avg 계산에 이 형식을 사용한다.
+   하위 14비트가 소수부, 그 위 17비트가 정수부, 최상위 비트가 부호이다. */
+#define F (1 << 14)                     /* 고정 소수점에서의 1. */
+
+/* 정수 N을 고정 소수점으로 변환한다. */
+static inline int
+int_to_fp (int n)
+{
+  return n * F;
+}
+
+/* 고정 소수점 X를 정수로 변환한다. (0 방향으로 버림) */
+static inline int
+fp_to_int (int x)
+{
+  return x / F;
+}
+
+/* 고정 소수점 X를 정수로 변환한다. (가장 가까운 정수로 반올림) */
+static inline int
+fp_to_int_round (int x)
+{
+  return x >= 0 ? (x + F / 2) / F : (x - F / 2) / F;
+}
+
+/* 고정 소수점끼리의 덧셈. */
+static inline int
+add_fp (int x, int y)
+{
+  return x + y;
+}
+
+/* 고정 소수점끼리의 뺄셈. */
+static inline int
+sub_fp (int x, int y)
+{
+  return x - y;
+}
+
+/* 고정 소수점 X와 정수 N의 덧셈. */
+static inline int
+add_mixed (int x, int n)
+{
+  return x + n * F;
+}
+
+/* 고정 소수점 X에서 정수 N을 뺀다. */
+static inline int
+sub_mixed (int x, int n)
+{
+  return x - n * F;
+}
+
+/* 고정 소수점끼리의 곱셈. 중간 결과가 32비트를 넘을 수 있으므로
+   64비트로 계산한다. */
+static inline int
+mult_fp (int x, int y)
+{
+  return ((int64_t) x) * y / F;
+}
+
+/* 고정 소수점 X와 정수 N의 곱셈. */
+static inline int
+mult_mixed (int x, int n)
+{
+  return x * n;
+}
+
+/* 고정 소수점끼리의 나눗셈. */
+static inline int
+div_fp (int x, int y)
+{
+  return ((int64_t) x) * F / y;
+}
+
+/* 고정 소수점 X를 정수 N으로 나눈다. */
+static inline int
+div_mixed (int x, int n)
+{
+  return x / n;
+}
+
+#endif /* threads/fixed_point.h */
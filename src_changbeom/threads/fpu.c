@@ -0,0 +1,223 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#ifdef USERPROG
+#include "userprog/syscall.h"
+#endif
+
+/* Lazy FPU/SSE context switching.
+
+   x87/SSE 레지스터는 FXSAVE/FXRSTOR로 512바이트 영역에 저장하고 복원한다.
+   context switch마다 저장하면 FPU를 쓰지 않는 스레드까지 비용을 치르므로,
+   레지스터에 들어있는 상태의 주인(fpu_owner)만 기억해두고 다른 스레드로
+   전환될 때 CR0.TS를 켠다. TS가 켜진 상태에서 FPU/SSE 명령을 실행하면
+   #NM이 발생하고, 그때 주인의 상태를 저장하고 현재 스레드의 상태를 복원한다.
+   커널은 -msoft-float로 컴파일되므로 FPU를 사용하지 않는다. */
+
+/* CR0 bits. */
+#define CR0_MP 0x00000002       /* Monitor coprocessor. */
+#define CR0_EM 0x00000004       /* (Floating-point) Emulation. */
+#define CR0_TS 0x00000008       /* Task switched. */
+#define CR0_NE 0x00000020       /* Native FPU error reporting. */
+
+/* CR4 bits. */
+#define CR4_OSFXSR 0x00000200   /* FXSAVE/FXRSTOR and SSE enabled. */
+#define CR4_OSXMMEXCPT 0x00000400 /* Unmasked SSE exceptions enabled. */
+
+/* CPUID.1:EDX feature bits. */
+#define CPUID_FXSR (1u << 24)
+#define CPUID_SSE (1u << 25)
+
+/* FXSAVE 영역의 크기와 정렬. */
+#define FXSAVE_SIZE 512
+#define FXSAVE_ALIGN 16
+
+/* FPU/SSE를 사용할 수 있으면 true. */
+static bool fpu_enabled;
+
+/* 현재 FPU 레지스터에 상태가 들어있는 스레드, 없으면 NULL. */
+static struct thread *fpu_owner;
+
+/* CR0.TS가 켜져 있으면 true. CR0를 매번 읽지 않기 위해 기억해둔다. */
+static bool fpu_ts;
+
+/* 처음 FPU를 사용하는 스레드에게 줄 초기 상태. */
+static uint8_t fpu_init_state[FXSAVE_SIZE] __attribute__ ((aligned (FXSAVE_ALIGN)));
+
+static void fpu_trap (struct intr_frame *);
+static void fpu_kill (void) NO_RETURN;
+
+static inline uint32_t
+read_cr0 (void) 
+{
+  uint32_t cr0;
+  asm volatile ("movl %%cr0, %0" : "=r" (cr0));
+  return cr0;
+}
+
+static inline void
+write_cr0 (uint32_t cr0) 
+{
+  asm volatile ("movl %0, %%cr0" : : "r" (cr0) : "memory");
+}
+
+/* Sets CR0.TS, so that the next FPU/SSE instruction traps. */
+static inline void
+fpu_disable (void) 
+{
+  if (!fpu_ts)
+    {
+      write_cr0 (read_cr0 () | CR0_TS);
+      fpu_ts = true;
+    }
+}
+
+/* Clears CR0.TS. */
+static inline void
+fpu_enable (void) 
+{
+  if (fpu_ts)
+    {
+      asm volatile ("clts" : : : "memory");
+      fpu_ts = false;
+    }
+}
+
+/* Returns T's 16-byte aligned FXSAVE area. */
+static inline void *
+fpu_area (struct thread *t) 
+{
+  return (void *) ROUND_UP ((uintptr_t) t->fpu_mem, FXSAVE_ALIGN);
+}
+
+/* CPU가 FXSAVE와 SSE를 지원하면 사용할 수 있게 설정하고
+   #NM handler를 등록한다. intr_init() 이후에 호출되어야 한다. */
+void
+fpu_init (void) 
+{
+  uint32_t eax = 1, ebx, ecx, edx;
+  uint32_t cr4;
+
+  intr_register_int (7, 0, INTR_ON, fpu_trap,
+                     "#NM Device Not Available Exception");
+
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  if ((edx & (CPUID_FXSR | CPUID_SSE)) != (CPUID_FXSR | CPUID_SSE))
+    {
+      printf ("FPU: no FXSR/SSE support, floating point disabled.\n");
+      return;
+    }
+
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4 | CR4_OSFXSR | CR4_OSXMMEXCPT));
+  write_cr0 ((read_cr0 () & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+
+  /* 깨끗한 초기 상태를 만들어서 저장해둔다. */
+  asm volatile ("fninit");
+  asm volatile ("ldmxcsr %0" : : "m" ((uint32_t) { 0x1f80 }));
+  asm volatile ("fxsave %0" : "=m" (fpu_init_state));
+
+  fpu_ts = false;
+  fpu_disable ();
+  fpu_enabled = true;
+}
+
+/* 스레드 T로 전환된 직후 thread_schedule_tail()에서 호출된다.
+   T의 상태가 이미 FPU에 들어있다면 TS를 꺼서 trap 없이 사용하게 하고,
+   아니면 TS를 켜서 처음 사용할 때 #NM이 발생하도록 한다. */
+void
+fpu_switch (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!fpu_enabled)
+    return;
+  if (t == fpu_owner)
+    fpu_enable ();
+  else
+    fpu_disable ();
+}
+
+/* 종료하는 스레드 T의 FPU 상태를 버린다. */
+void
+fpu_exit (struct thread *t) 
+{
+  enum intr_level old_level;
+  void *mem;
+
+  old_level = intr_disable ();
+  if (fpu_owner == t)
+    {
+      fpu_owner = NULL;
+      fpu_disable ();
+    }
+  mem = t->fpu_mem;
+  t->fpu_mem = NULL;
+  intr_set_level (old_level);
+
+  free (mem);
+}
+
+/* FPU를 쓸 수 없는 유저 스레드를 종료한다. 그 스레드만 죽으면 같은
+   프로세스의 다른 스레드들이 남으므로 exit()으로 프로세스 전체를 종료한다. */
+static void
+fpu_kill (void)
+{
+#ifdef USERPROG
+  exit (-1);
+#else
+  thread_current ()->exit_status = -1;
+  thread_exit ();
+#endif
+}
+
+/* #NM handler. 현재 스레드가 처음 FPU를 사용하면 상태를 저장할 영역을
+   할당하고, FPU에 들어있는 다른 스레드의 상태를 저장한 뒤
+   현재 스레드의 상태를 복원한다. */
+static void
+fpu_trap (struct intr_frame *f) 
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  if (f->cs == SEL_KCSEG)
+    {
+      intr_dump_frame (f);
+      PANIC ("Kernel bug - FPU used in kernel");
+    }
+
+  if (!fpu_enabled)
+    {
+      printf ("%s: dying due to interrupt %#04x (%s).\n",
+              thread_name (), f->vec_no, intr_name (f->vec_no));
+      fpu_kill ();
+    }
+
+  if (cur->fpu_mem == NULL)
+    {
+      void *mem = malloc (FXSAVE_SIZE + FXSAVE_ALIGN - 1);
+      if (mem == NULL)
+        fpu_kill ();
+      cur->fpu_mem = mem;
+      memcpy (fpu_area (cur), fpu_init_state, FXSAVE_SIZE);
+    }
+
+  /* 상태를 바꾸는 동안 다른 스레드로 전환되지 않도록 한다. */
+  old_level = intr_disable ();
+  fpu_enable ();
+  if (fpu_owner != cur)
+    {
+      if (fpu_owner != NULL)
+        asm volatile ("fxsave (%0)" : : "r" (fpu_area (fpu_owner)) : "memory");
+      asm volatile ("fxrstor (%0)" : : "r" (fpu_area (cur)) : "memory");
+      fpu_owner = cur;
+    }
+  intr_set_level (old_level);
+}
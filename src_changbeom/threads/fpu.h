@@ -0,0 +1,12 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+void fpu_init (void);
+void fpu_switch (struct thread *);
+void fpu_exit (struct thread *);
+
+#endif /* threads/fpu.h */
@@ -1,4 +1,5 @@
 #include "threads/init.h"
+#include "threads/fpu.h"
 #include <console.h>
 #include <debug.h>
 #include <inttypes.h>
@@ -22,12 +23,14 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "vm/page.h"
 #else
 #include "tests/threads/tests.h"
 #endif
@@ -97,6 +100,7 @@ main (void)
   /* Initialize memory system. */
   palloc_init (user_page_limit);
   malloc_init ();
+  rwlock_cache_init ();
   paging_init ();
 
   /* Segmentation. */
@@ -107,12 +111,14 @@ main (void)
 
   /* Initialize interrupt handlers. */
   intr_init ();
+  fpu_init ();
   timer_init ();
   kbd_init ();
   input_init ();
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  vm_cache_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
@@ -258,6 +264,12 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-cfs"))
+        thread_cfs = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
+      else if (!strcmp (name, "-trace"))
+        trace_dump_on_shutdown = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -265,6 +277,8 @@ parse_options (char **argv)
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
     }
+  if (thread_mlfqs && thread_cfs)
+    PANIC ("-mlfqs and -cfs cannot be used together");
 
   /* Initialize the random number generator based on the system
      time.  This has no effect if an "-rs" option was specified.
@@ -381,6 +395,9 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -cfs               Use fair-share scheduler with virtual runtime.\n"
+          "  -tickless          Stop the periodic timer tick while idle.\n"
+          "  -trace             Dump the scheduler event trace at shutdown.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
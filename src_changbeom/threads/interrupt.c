@@ -9,6 +9,10 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/process.h"
+#endif
 
 /* Programmable Interrupt Controller (PIC) registers.
    A PC has two PICs, called the master and slave PICs, with the
@@ -47,6 +51,31 @@ static unsigned int unexpected_cnt[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+#ifdef INTR_TRACE
+/* Interrupt를 끈 구간들 중 가장 긴 IRQOFF_TOP_CNT개를 기록한다.
+   "make INTR_TRACE=1"로 빌드했을 때만 포함되며, 종료할 때
+   intr_print_stats()가 출력한다. 같은 곳에서 시작한 구간은 가장 긴 것
+   하나만 남긴다. 주소는 utils/backtrace로 함수 이름을 찾을 수 있다. */
+#define IRQOFF_TOP_CNT 8
+
+struct irqoff_window
+  {
+    uint64_t cycles;            /* Interrupt가 꺼져 있던 시간 (TSC). */
+    void *eip;                  /* Interrupt를 끈 곳. */
+  };
+
+static struct irqoff_window irqoff_top[IRQOFF_TOP_CNT];
+static uint64_t irqoff_start;   /* 현재 구간이 시작된 TSC, 없으면 0. */
+static void *irqoff_eip;        /* 현재 구간을 시작한 곳. */
+static uint64_t irqoff_cnt;     /* 측정한 구간의 수. */
+
+static void irqoff_begin (void *eip);
+static void irqoff_end (void);
+#endif
+
+static enum intr_level do_intr_enable (void *caller);
+static enum intr_level do_intr_disable (void *caller);
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -80,16 +109,39 @@ intr_get_level (void)
 enum intr_level
 intr_set_level (enum intr_level level) 
 {
-  return level == INTR_ON ? intr_enable () : intr_disable ();
+  void *caller = __builtin_return_address (0);
+
+  return (level == INTR_ON
+          ? do_intr_enable (caller)
+          : do_intr_disable (caller));
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_enable (void) 
+{
+  return do_intr_enable (__builtin_return_address (0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable (void) 
+{
+  return do_intr_disable (__builtin_return_address (0));
+}
+
+/* intr_enable()의 본체. CALLER는 interrupt를 켠 곳이다. */
+static inline enum intr_level
+do_intr_enable (void *caller UNUSED)
 {
   enum intr_level old_level = intr_get_level ();
   ASSERT (!intr_context ());
 
+#ifdef INTR_TRACE
+  if (old_level == INTR_OFF)
+    irqoff_end ();
+#endif
+
   /* Enable interrupts by setting the interrupt flag.
 
      See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -99,9 +151,9 @@ intr_enable (void)
   return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable (void) 
+/* intr_disable()의 본체. CALLER는 interrupt를 끈 곳이다. */
+static inline enum intr_level
+do_intr_disable (void *caller UNUSED)
 {
   enum intr_level old_level = intr_get_level ();
 
@@ -110,8 +162,75 @@ intr_disable (void)
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
 
+#ifdef INTR_TRACE
+  if (old_level == INTR_ON)
+    irqoff_begin (caller);
+#endif
+
   return old_level;
 }
+
+#ifdef INTR_TRACE
+/* EIP에서 interrupt를 끈 구간을 시작한다. */
+static void
+irqoff_begin (void *eip)
+{
+  irqoff_start = timer_tsc ();
+  irqoff_eip = eip;
+}
+
+/* 현재 구간을 끝내고, 지금까지 가장 긴 구간들 중 하나라면 irqoff_top에
+   기록한다. irqoff_top은 긴 순서로 정렬되어 있다. */
+static void
+irqoff_end (void)
+{
+  uint64_t cycles;
+  int i, j;
+
+  if (irqoff_start == 0)
+    return;
+  cycles = timer_tsc () - irqoff_start;
+  irqoff_start = 0;
+  irqoff_cnt++;
+
+  /* 가장 짧은 기록보다 짧으면 바로 돌아간다. */
+  if (cycles <= irqoff_top[IRQOFF_TOP_CNT - 1].cycles)
+    return;
+
+  /* 같은 곳의 기록이 있으면 그 자리를, 없으면 마지막 자리를 비운다. */
+  for (j = 0; j < IRQOFF_TOP_CNT - 1; j++)
+    if (irqoff_top[j].eip == irqoff_eip)
+      break;
+  if (cycles <= irqoff_top[j].cycles)
+    return;
+
+  /* 더 짧은 기록들을 한 칸씩 뒤로 밀고 끼워 넣는다. */
+  for (i = j; i > 0 && irqoff_top[i - 1].cycles < cycles; i--)
+    irqoff_top[i] = irqoff_top[i - 1];
+  irqoff_top[i].cycles = cycles;
+  irqoff_top[i].eip = irqoff_eip;
+}
+
+/* Interrupt를 끈 구간들 중 가장 긴 것들을 출력한다. */
+void
+intr_print_stats (void)
+{
+  uint64_t hz = timer_tsc_hz ();
+  int i;
+
+  printf ("Interrupts off: %"PRIu64" windows, longest:\n", irqoff_cnt);
+  for (i = 0; i < IRQOFF_TOP_CNT && irqoff_top[i].cycles != 0; i++)
+    {
+      const struct irqoff_window *w = &irqoff_top[i];
+
+      if (hz != 0)
+        printf ("  %8"PRIu64" us %12"PRIu64" cycles  from %p\n",
+                w->cycles * 1000000 / hz, w->cycles, w->eip);
+      else
+        printf ("  %12"PRIu64" cycles  from %p\n", w->cycles, w->eip);
+    }
+}
+#endif /* INTR_TRACE */
 
 /* Initializes the interrupt system. */
 void
@@ -352,6 +471,15 @@ intr_handler (struct intr_frame *frame)
      and they need to be acknowledged on the PIC (see below).
      An external interrupt handler cannot sleep. */
   external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+
+#ifdef INTR_TRACE
+  /* Interrupt gate로 들어왔다면 여기서부터 interrupt가 꺼져 있다.
+     interrupt가 켜져 있던 곳에서 들어왔으므로, 남아 있는 구간은 idle
+     thread의 "sti; hlt"처럼 측정하지 못한 곳에서 이미 끝난 것이다. */
+  if ((frame->eflags & FLAG_IF) != 0 && intr_get_level () == INTR_OFF)
+    irqoff_begin (intr_handlers[frame->vec_no]);
+#endif
+
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
@@ -386,6 +514,19 @@ intr_handler (struct intr_frame *frame)
       if (yield_on_return) 
         thread_yield (); 
     }
+
+#ifdef USERPROG
+  /* 유저 모드로 돌아가기 직전에, 같은 프로세스의 다른 스레드가
+     exit()을 호출했다면 이 스레드도 종료한다. */
+  if (frame->cs == SEL_UCSEG)
+    process_check_exit ();
+#endif
+
+#ifdef INTR_TRACE
+  /* iret이 interrupt를 다시 켠다. */
+  if ((frame->eflags & FLAG_IF) != 0 && intr_get_level () == INTR_OFF)
+    irqoff_end ();
+#endif
 }
 
 /* Handles an unexpected interrupt with interrupt frame F.  An
@@ -15,6 +15,9 @@ enum intr_level intr_get_level (void);
 enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
+#ifdef INTR_TRACE
+void intr_print_stats (void);
+#endif
 
 /* Interrupt stack frame. */
 struct intr_frame
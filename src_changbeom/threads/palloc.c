@@ -2,11 +2,13 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -25,12 +27,54 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
+/* 각 pool은 binary buddy allocator로 관리한다.
+   빈 page들은 2^order개씩 정렬된 block으로 묶여 order별 free list에
+   들어 있고, free list의 list_elem은 빈 block의 첫 page에 저장한다.
+   할당할 때는 필요한 크기 이상인 가장 작은 block을 반으로 나누어 가며
+   찾고, 해제할 때는 buddy block이 비어 있으면 계속 합친다. 그래서
+   할당과 해제 모두 pool 크기가 아닌 order 수에 비례하는 시간이 걸린다.
+   page 수가 2의 거듭제곱이 아닌 요청은 2^order 크기의 block을 할당한 뒤
+   남는 뒷부분을 다시 free list에 돌려주므로 요청한 page만 사용한다.
+   block의 위치와 정렬은 pool의 base를 기준으로 한다.
+
+   PAL_ZERO 할당이 page fault 처리 중에 4 kB를 지우지 않아도 되도록,
+   idle thread가 palloc_zero_idle()로 빈 page들을 미리 0으로 채워 둔다.
+   dirty_map은 비어 있지만 아직 0으로 채우지 않은 page들을 표시한다.
+   빈 block의 첫 page 앞부분에는 free list의 list_elem이 들어 있으므로
+   "0으로 채웠다"는 것은 처음 ZERO_SKIP bytes를 뺀 나머지가 0이라는
+   뜻이고, PAL_ZERO 할당은 각 page의 처음 ZERO_SKIP bytes만 지운다.
+   각 free list에서 모두 0으로 채워진 block은 앞쪽에, dirty page가 있는
+   block은 뒤쪽에 둔다. PAL_ZERO 할당은 앞쪽에서 0으로 채워진 block을
+   먼저 찾고, 나머지 할당은 뒤쪽의 dirty block부터 가져간다. */
+
+/* 미리 0으로 채운 page에서도 할당할 때 지워야 하는 앞부분의 크기. */
+#define ZERO_SKIP sizeof (struct list_elem)
+
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages in pool. */
+
+    /* order별 빈 block들의 list와 그 길이. */
+    struct list free_list[PALLOC_ORDER_CNT];
+    size_t free_cnt[PALLOC_ORDER_CNT];
+
+    /* page마다 하나씩, 그 page가 빈 block의 첫 page이면 order + 1,
+       아니면 0. buddy가 비어 있는지 상수 시간에 확인하는 데 쓴다. */
+    uint8_t *free_order;
+
+    /* 비어 있지만 0으로 채우지 않은 page들과 그 수. 이것과 free list의
+       순서는 LOCK을 잡거나, interrupt를 끄고 LOCK을 아무도 잡고 있지
+       않을 때만 바꾼다. */
+    struct bitmap *dirty_map;
+    size_t dirty_cnt;
+
+    /* PAL_ZERO로 할당한 page 수와 그중 미리 0으로 채워져 있던 수. */
+    size_t zero_allocs;
+    size_t zero_hits;
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +83,14 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static struct list_elem *block_elem (struct pool *, size_t page_idx);
+static void block_push (struct pool *, size_t page_idx, int order);
+static void block_remove (struct pool *, size_t page_idx, int order);
+static bool block_clean (struct pool *, size_t page_idx, int order);
+static void block_zeroed (struct pool *, size_t page_idx);
+static size_t buddy_alloc (struct pool *, size_t page_cnt, bool zero);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void buddy_free_block (struct pool *, size_t page_idx, int order);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -73,12 +125,27 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
   size_t page_idx;
+  size_t dirty = 0;
 
   if (page_cnt == 0)
     return NULL;
 
   lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+  page_idx = buddy_alloc (pool, page_cnt, (flags & PAL_ZERO) != 0);
+  if (page_idx != BITMAP_ERROR)
+    {
+      dirty = bitmap_count (pool->dirty_map, page_idx, page_cnt, true);
+
+      ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+      bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+      bitmap_set_multiple (pool->dirty_map, page_idx, page_cnt, false);
+      pool->dirty_cnt -= dirty;
+      if (flags & PAL_ZERO)
+        {
+          pool->zero_allocs += page_cnt;
+          pool->zero_hits += page_cnt - dirty;
+        }
+    }
   lock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
@@ -88,8 +155,15 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && dirty > 0)
         memset (pages, 0, PGSIZE * page_cnt);
+      else if (flags & PAL_ZERO)
+        {
+          /* 모두 미리 0으로 채워 둔 page들이다. */
+          size_t i;
+          for (i = 0; i < page_cnt; i++)
+            memset ((uint8_t *) pages + PGSIZE * i, 0, ZERO_SKIP);
+        }
     }
   else 
     {
@@ -137,8 +211,13 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  lock_acquire (&pool->lock);
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  bitmap_set_multiple (pool->dirty_map, page_idx, page_cnt, true);
+  pool->dirty_cnt += page_cnt;
+  buddy_free (pool, page_idx, page_cnt);
+  lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +227,292 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* 0으로 채우지 않은 빈 page 하나를 0으로 채운다. user pool을 먼저
+   채운다. 채운 page가 있으면 true, 없으면 false를 반환한다.
+   idle thread가 interrupt를 끈 채로 호출한다. pool의 lock을 잡고 있는
+   스레드가 있으면 그 pool은 건드리지 않으므로 idle thread가 block되지
+   않는다. 한 번에 page 하나만 채워 interrupt가 꺼져 있는 시간을 짧게
+   유지한다. */
+bool
+palloc_zero_idle (void)
+{
+  struct pool *pools[2] = {&user_pool, &kernel_pool};
+  int i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (i = 0; i < 2; i++)
+    {
+      struct pool *pool = pools[i];
+      size_t page_idx;
+
+      if (pool->dirty_cnt == 0 || pool->lock.holder != NULL)
+        continue;
+
+      page_idx = bitmap_scan (pool->dirty_map, 0, 1, true);
+      ASSERT (page_idx != BITMAP_ERROR);
+      memset (pool->base + PGSIZE * page_idx + ZERO_SKIP, 0,
+              PGSIZE - ZERO_SKIP);
+      bitmap_reset (pool->dirty_map, page_idx);
+      pool->dirty_cnt--;
+      block_zeroed (pool, page_idx);
+      return true;
+    }
+  return false;
+}
+
+/* FLAGS의 PAL_USER에 해당하는 pool의 상태를 STATS에 채운다. */
+void
+palloc_get_stats (enum palloc_flags flags, struct palloc_stats *stats)
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  int order;
+
+  lock_acquire (&pool->lock);
+  stats->page_cnt = pool->page_cnt;
+  stats->dirty_pages = pool->dirty_cnt;
+  stats->zero_allocs = pool->zero_allocs;
+  stats->zero_hits = pool->zero_hits;
+  stats->free_pages = 0;
+  stats->largest_free = 0;
+  for (order = 0; order < PALLOC_ORDER_CNT; order++)
+    {
+      stats->free_blocks[order] = pool->free_cnt[order];
+      stats->free_pages += pool->free_cnt[order] << order;
+      if (pool->free_cnt[order] > 0)
+        stats->largest_free = (size_t) 1 << order;
+    }
+  lock_release (&pool->lock);
+}
+
+/* 두 pool의 빈 page 수와 단편화 정도를 출력한다.
+   단편화는 빈 page들 중 가장 큰 빈 block에 들어 있지 않은 비율이다. */
+void
+palloc_print_stats (void)
+{
+  static const char *names[2] = {"kernel", "user"};
+  int i;
+
+  for (i = 0; i < 2; i++)
+    {
+      struct palloc_stats stats;
+      int order;
+
+      palloc_get_stats (i == 0 ? 0 : PAL_USER, &stats);
+      printf ("Palloc: %s pool: %zu of %zu pages free, "
+              "largest free block %zu pages, %zu%% fragmented\n",
+              names[i], stats.free_pages, stats.page_cnt, stats.largest_free,
+              stats.free_pages != 0
+              ? 100 - stats.largest_free * 100 / stats.free_pages : 0);
+      printf ("  %zu free pages pre-zeroed, "
+              "%zu of %zu PAL_ZERO pages were pre-zeroed\n",
+              stats.free_pages - stats.dirty_pages,
+              stats.zero_hits, stats.zero_allocs);
+      printf ("  free blocks by order:");
+      for (order = 0; order < PALLOC_ORDER_CNT; order++)
+        printf (" %zu", stats.free_blocks[order]);
+      printf ("\n");
+    }
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's used_map, dirty_map and free_order at
+     its base.  Calculate the space needed for them
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t meta_pages = DIV_ROUND_UP (2 * bm_size + page_cnt, PGSIZE);
+  int order;
+
+  if (meta_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  page_cnt -= meta_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->dirty_map = bitmap_create_in_buf (page_cnt, (uint8_t *) base + bm_size,
+                                       bm_size);
+  p->free_order = (uint8_t *) base + 2 * bm_size;
+  memset (p->free_order, 0, page_cnt);
+  p->base = base + meta_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  bitmap_set_all (p->dirty_map, true);
+  p->dirty_cnt = page_cnt;
+  p->zero_allocs = p->zero_hits = 0;
+  for (order = 0; order < PALLOC_ORDER_CNT; order++)
+    {
+      list_init (&p->free_list[order]);
+      p->free_cnt[order] = 0;
+    }
+
+  /* 모든 page를 가능한 큰 block들로 free list에 넣는다. */
+  buddy_free (p, 0, page_cnt);
+}
+
+/* POOL의 PAGE_IDX번째 page에 저장된 free list element를 반환한다. */
+static struct list_elem *
+block_elem (struct pool *pool, size_t page_idx)
+{
+  return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* PAGE_IDX에서 시작하는 2^ORDER개 page의 빈 block을 free list에 넣는다.
+   모두 0으로 채워진 block은 앞에, 아니면 뒤에 넣는다. */
+static void
+block_push (struct pool *pool, size_t page_idx, int order)
+{
+  if (block_clean (pool, page_idx, order))
+    list_push_front (&pool->free_list[order], block_elem (pool, page_idx));
+  else
+    list_push_back (&pool->free_list[order], block_elem (pool, page_idx));
+  pool->free_cnt[order]++;
+  pool->free_order[page_idx] = order + 1;
+}
+
+/* PAGE_IDX에서 시작하는 ORDER의 빈 block을 free list에서 뺀다. */
+static void
+block_remove (struct pool *pool, size_t page_idx, int order)
+{
+  ASSERT (pool->free_order[page_idx] == order + 1);
+
+  list_remove (block_elem (pool, page_idx));
+  pool->free_cnt[order]--;
+  pool->free_order[page_idx] = 0;
+}
+
+/* PAGE_IDX에서 시작하는 2^ORDER개 page가 모두 0으로 채워져 있으면
+   true를 반환한다. */
+static bool
+block_clean (struct pool *pool, size_t page_idx, int order)
+{
+  return !bitmap_contains (pool->dirty_map, page_idx,
+                           (size_t) 1 << order, true);
+}
+
+/* PAGE_IDX를 0으로 채운 뒤 호출한다. PAGE_IDX가 들어 있는 빈 block에
+   더 이상 dirty page가 없으면 그 block을 free list 앞으로 옮긴다. */
+static void
+block_zeroed (struct pool *pool, size_t page_idx)
+{
+  int order;
+
+  for (order = 0; order < PALLOC_ORDER_CNT; order++)
+    {
+      size_t head = page_idx & ~(((size_t) 1 << order) - 1);
+
+      if (pool->free_order[head] == order + 1)
+        {
+          if (block_clean (pool, head, order))
+            {
+              list_remove (block_elem (pool, head));
+              list_push_front (&pool->free_list[order],
+                               block_elem (pool, head));
+            }
+          return;
+        }
+    }
+}
+
+/* POOL에서 PAGE_CNT개의 연속된 page를 할당하고 첫 page의 번호를
+   반환한다. 빈 block이 없으면 BITMAP_ERROR를 반환한다.
+   ZERO가 true이면 크기가 더 크더라도 0으로 채워진 block을 먼저 쓰고,
+   false이면 dirty block부터 쓴다.
+   POOL의 lock을 잡은 상태에서 호출되어야 한다. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt, bool zero)
+{
+  struct list_elem *e;
+  size_t page_idx;
+  int order, found;
+
+  /* PAGE_CNT를 담을 수 있는 가장 작은 order. */
+  for (order = 0; order < PALLOC_ORDER_CNT; order++)
+    if (((size_t) 1 << order) >= page_cnt)
+      break;
+  if (order == PALLOC_ORDER_CNT)
+    return BITMAP_ERROR;
+
+  /* PAL_ZERO이면 그 이상인 가장 작은 0으로 채워진 block을 찾는다.
+     0으로 채워진 block은 free list 앞쪽에 있으므로 맨 앞만 보면 된다. */
+  found = PALLOC_ORDER_CNT;
+  if (zero)
+    for (found = order; found < PALLOC_ORDER_CNT; found++)
+      if (!list_empty (&pool->free_list[found])
+          && block_clean (pool, pg_no (list_front (&pool->free_list[found]))
+                                - pg_no (pool->base), found))
+        break;
+
+  /* 없으면 그 이상인 가장 작은 빈 block을 찾는다. */
+  if (found == PALLOC_ORDER_CNT)
+    for (found = order; found < PALLOC_ORDER_CNT; found++)
+      if (!list_empty (&pool->free_list[found]))
+        break;
+  if (found == PALLOC_ORDER_CNT)
+    return BITMAP_ERROR;
+
+  e = zero ? list_front (&pool->free_list[found])
+           : list_back (&pool->free_list[found]);
+  page_idx = pg_no (e) - pg_no (pool->base);
+  block_remove (pool, page_idx, found);
+
+  /* 필요한 크기가 될 때까지 반으로 나누고 뒤쪽 절반을 돌려준다. */
+  while (found > order)
+    {
+      found--;
+      block_push (pool, page_idx + ((size_t) 1 << found), found);
+    }
+
+  /* 2^order개 중 쓰지 않는 뒷부분도 돌려준다. */
+  if (page_cnt < (size_t) 1 << order)
+    buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+
+  return page_idx;
+}
+
+/* POOL의 PAGE_IDX부터 PAGE_CNT개의 page를 free list에 돌려준다.
+   범위를 정렬된 2의 거듭제곱 크기의 block들로 나누어 각각 해제한다.
+   POOL의 lock을 잡은 상태에서 호출되어야 한다. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = 0;
+
+      while (order + 1 < PALLOC_ORDER_CNT
+             && page_idx % ((size_t) 1 << (order + 1)) == 0
+             && ((size_t) 1 << (order + 1)) <= page_cnt)
+        order++;
+      buddy_free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* PAGE_IDX에서 시작하는 ORDER의 block을 해제한다. buddy block이 비어
+   있으면 합쳐서 한 단계 큰 block으로 만드는 것을 반복한다. */
+static void
+buddy_free_block (struct pool *pool, size_t page_idx, int order)
+{
+  while (order + 1 < PALLOC_ORDER_CNT)
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+      if (buddy + ((size_t) 1 << order) > pool->page_cnt
+          || pool->free_order[buddy] != order + 1)
+        break;
+      block_remove (pool, buddy, order);
+      if (buddy < page_idx)
+        page_idx = buddy;
+      order++;
+    }
+  block_push (pool, page_idx, order);
 }
 
 /* Returns true if PAGE was allocated from POOL,
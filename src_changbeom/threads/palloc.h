@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /* How to allocate pages. */
@@ -11,10 +12,29 @@ enum palloc_flags
     PAL_USER = 004              /* User page. */
   };
 
+/* buddy allocator의 order 수. 한 번에 할당할 수 있는 page 수는
+   최대 2^(PALLOC_ORDER_CNT - 1)이다. */
+#define PALLOC_ORDER_CNT 11
+
+/* palloc_get_stats()가 채워주는 pool의 상태. */
+struct palloc_stats
+  {
+    size_t page_cnt;                    /* Pool의 전체 page 수. */
+    size_t free_pages;                  /* 빈 page 수. */
+    size_t dirty_pages;                 /* 그중 0으로 채우지 않은 수. */
+    size_t zero_allocs;                 /* PAL_ZERO로 할당한 page 수. */
+    size_t zero_hits;                   /* 그중 미리 0으로 채워진 수. */
+    size_t largest_free;                /* 가장 큰 빈 block의 page 수. */
+    size_t free_blocks[PALLOC_ORDER_CNT]; /* order별 빈 block 수. */
+  };
+
 void palloc_init (size_t user_page_limit);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_get_stats (enum palloc_flags, struct palloc_stats *);
+void palloc_print_stats (void);
+bool palloc_zero_idle (void);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,318 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator.
+
+   malloc()은 요청 크기를 2의 거듭제곱으로 올려서 나눠주므로 40 bytes짜리
+   구조체도 64 bytes를 차지하고, 같은 크기의 모든 할당이 descriptor 하나의
+   lock을 공유한다.  자주 만들고 없애는 kernel 구조체들은 타입마다
+   kmem_cache를 두고 그 크기에 딱 맞게 자른 page ("slab")에서 할당한다.
+
+   slab은 page 하나이고, 맨 앞에 struct slab header, 그 뒤에 빈 객체
+   번호들의 stack, 그 뒤에 객체들이 온다.  객체 안에 free list의 link를
+   두지 않으므로 constructor가 초기화한 내용은 해제된 뒤에도 남아 있고,
+   constructor는 객체가 slab에 처음 만들어질 때 한 번만 호출된다.
+
+   각 cache는 최근에 해제된 객체 몇 개를 magazine에 모아 둔다.  단일
+   CPU이므로 magazine은 interrupt만 끄고 다루면 되고, magazine이 비었거나
+   가득 찼을 때만 cache의 lock을 잡고 slab을 다룬다. */
+
+/* Magazine에 보관하는 객체 수. */
+#define KMEM_MAG_SIZE 16
+
+/* 객체 크기의 정렬 단위. */
+#define KMEM_ALIGN sizeof (void *)
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Object cache. */
+struct kmem_cache
+  {
+    char name[16];              /* 출력용 이름. */
+    size_t obj_size;            /* 정렬한 객체 크기. */
+    size_t objs_per_slab;       /* slab 하나의 객체 수. */
+    size_t obj_ofs;             /* slab 안의 첫 객체의 offset. */
+    void (*ctor) (void *);      /* 객체 constructor, 없으면 null. */
+    struct list_elem elem;      /* cache_list의 element. */
+
+    /* 아래는 LOCK으로 보호한다. */
+    struct lock lock;
+    struct list slabs;          /* 빈 객체가 있는 slab들. */
+    size_t slab_cnt;            /* 전체 slab 수. */
+    size_t empty_cnt;           /* 객체를 하나도 쓰지 않는 slab 수. */
+    size_t slab_active;         /* slab에서 꺼낸 객체 수. */
+
+    /* 아래는 interrupt를 끄고 다룬다. */
+    void *mag[KMEM_MAG_SIZE];   /* 최근에 해제된 객체들. */
+    size_t mag_cnt;             /* MAG에 있는 객체 수. */
+    size_t alloc_cnt;           /* 할당 횟수. */
+    size_t mag_hits;            /* magazine에서 준 횟수. */
+  };
+
+/* Slab header.  slab page의 맨 앞에 있다. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* cache의 slabs list element. */
+    size_t free_cnt;            /* 빈 객체 수. */
+    uint16_t free_idx[];        /* 빈 객체 번호들의 stack. */
+  };
+
+/* 만들어진 모든 cache. */
+static struct list cache_list = LIST_INITIALIZER (cache_list);
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+static void *slab_alloc (struct kmem_cache *);
+static void slab_free (struct kmem_cache *, void *);
+
+/* SIZE bytes짜리 객체들을 위한 cache NAME을 만들어 반환한다.
+   CTOR가 null이 아니면 slab에 새 객체가 만들어질 때마다 호출된다.
+   kmem_cache_free()에 돌려주는 객체는 CTOR가 만든 상태로 돌려놓아야
+   한다.  메모리가 없으면 null pointer를 반환한다. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, void (*ctor) (void *))
+{
+  struct kmem_cache *c;
+  size_t obj_size = ROUND_UP (size > 0 ? size : 1, KMEM_ALIGN);
+  size_t n;
+  enum intr_level old_level;
+
+  /* header, 번호 stack, 객체들이 page 하나에 들어가는 최대 개수. */
+  n = (PGSIZE - sizeof (struct slab)) / (obj_size + sizeof (uint16_t));
+  while (n > 0 && ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+                            KMEM_ALIGN) + n * obj_size > PGSIZE)
+    n--;
+  ASSERT (n > 0);
+
+  c = malloc (sizeof *c);
+  if (c == NULL)
+    return NULL;
+
+  strlcpy (c->name, name, sizeof c->name);
+  c->obj_size = obj_size;
+  c->objs_per_slab = n;
+  c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+                         KMEM_ALIGN);
+  c->ctor = ctor;
+  lock_init (&c->lock);
+  list_init (&c->slabs);
+  c->slab_cnt = c->empty_cnt = c->slab_active = 0;
+  c->mag_cnt = c->alloc_cnt = c->mag_hits = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&cache_list, &c->elem);
+  intr_set_level (old_level);
+
+  return c;
+}
+
+/* CACHE에서 객체 하나를 할당해 반환한다.
+   메모리가 없으면 null pointer를 반환한다. */
+void *
+kmem_cache_alloc (struct kmem_cache *cache)
+{
+  enum intr_level old_level;
+  void *obj = NULL;
+
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  cache->alloc_cnt++;
+  if (cache->mag_cnt > 0)
+    {
+      obj = cache->mag[--cache->mag_cnt];
+      cache->mag_hits++;
+    }
+  intr_set_level (old_level);
+
+  if (obj == NULL)
+    {
+      lock_acquire (&cache->lock);
+      obj = slab_alloc (cache);
+      lock_release (&cache->lock);
+    }
+  return obj;
+}
+
+/* CACHE에서 할당한 객체 OBJ를 해제한다. */
+void
+kmem_cache_free (struct kmem_cache *cache, void *obj)
+{
+  enum intr_level old_level;
+  bool cached = false;
+
+  ASSERT (!intr_context ());
+
+  if (obj == NULL)
+    return;
+  ASSERT (obj_to_slab (cache, obj) != NULL);
+
+#ifndef NDEBUG
+  /* Constructor가 없는 객체는 use-after-free를 찾기 쉽도록 지운다. */
+  if (cache->ctor == NULL)
+    memset (obj, 0xcc, cache->obj_size);
+#endif
+
+  old_level = intr_disable ();
+  if (cache->mag_cnt < KMEM_MAG_SIZE)
+    {
+      cache->mag[cache->mag_cnt++] = obj;
+      cached = true;
+    }
+  intr_set_level (old_level);
+
+  if (!cached)
+    {
+      lock_acquire (&cache->lock);
+      slab_free (cache, obj);
+      lock_release (&cache->lock);
+    }
+}
+
+/* CACHE의 상태를 STATS에 채운다. */
+void
+kmem_cache_get_stats (struct kmem_cache *cache, struct kmem_cache_stats *stats)
+{
+  enum intr_level old_level;
+
+  lock_acquire (&cache->lock);
+  old_level = intr_disable ();
+  stats->obj_size = cache->obj_size;
+  stats->objs_per_slab = cache->objs_per_slab;
+  stats->slab_cnt = cache->slab_cnt;
+  stats->active = cache->slab_active - cache->mag_cnt;
+  stats->alloc_cnt = cache->alloc_cnt;
+  stats->mag_hits = cache->mag_hits;
+  intr_set_level (old_level);
+  lock_release (&cache->lock);
+}
+
+/* 모든 cache의 사용량을 출력한다. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&cache_list); e != list_end (&cache_list);
+       e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+      struct kmem_cache_stats s;
+
+      kmem_cache_get_stats (c, &s);
+      printf ("Slab: %s: %zu of %zu objects of %zu bytes in use, "
+              "%zu slabs, %zu allocs (%zu from magazine)\n",
+              c->name, s.active, s.slab_cnt * s.objs_per_slab, s.obj_size,
+              s.slab_cnt, s.alloc_cnt, s.mag_hits);
+    }
+}
+
+/* CACHE를 위한 새 slab을 만들어 slabs list에 넣고 반환한다.
+   메모리가 없으면 null pointer를 반환한다. */
+static struct slab *
+slab_create (struct kmem_cache *cache)
+{
+  struct slab *s = palloc_get_page (0);
+  size_t i;
+
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = cache;
+  s->free_cnt = cache->objs_per_slab;
+  for (i = 0; i < cache->objs_per_slab; i++)
+    {
+      /* 앞 번호의 객체부터 나가도록 거꾸로 쌓는다. */
+      s->free_idx[i] = cache->objs_per_slab - 1 - i;
+      if (cache->ctor != NULL)
+        cache->ctor ((uint8_t *) s + cache->obj_ofs + i * cache->obj_size);
+    }
+  list_push_back (&cache->slabs, &s->elem);
+  cache->slab_cnt++;
+  cache->empty_cnt++;
+  return s;
+}
+
+/* CACHE에서 할당한 객체 OBJ가 들어 있는 slab을 반환한다. */
+static struct slab *
+obj_to_slab (struct kmem_cache *cache, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == cache);
+  ASSERT (pg_ofs (obj) >= cache->obj_ofs);
+  ASSERT ((pg_ofs (obj) - cache->obj_ofs) % cache->obj_size == 0);
+  return s;
+}
+
+/* CACHE의 slab에서 객체 하나를 꺼낸다.
+   CACHE의 lock을 잡은 상태에서 호출되어야 한다. */
+static void *
+slab_alloc (struct kmem_cache *cache)
+{
+  struct slab *s;
+  size_t idx;
+
+  if (list_empty (&cache->slabs) && slab_create (cache) == NULL)
+    return NULL;
+
+  /* 일부만 쓰인 slab들이 list의 앞에 있다. */
+  s = list_entry (list_front (&cache->slabs), struct slab, elem);
+  if (s->free_cnt == cache->objs_per_slab)
+    cache->empty_cnt--;
+  idx = s->free_idx[--s->free_cnt];
+  if (s->free_cnt == 0)
+    list_remove (&s->elem);
+  cache->slab_active++;
+
+  return (uint8_t *) s + cache->obj_ofs + idx * cache->obj_size;
+}
+
+/* 객체 OBJ를 자기 slab에 돌려준다.  slab이 완전히 비면, 이미 빈 slab이
+   하나 있을 경우 page를 palloc에 돌려준다.
+   CACHE의 lock을 잡은 상태에서 호출되어야 한다. */
+static void
+slab_free (struct kmem_cache *cache, void *obj)
+{
+  struct slab *s = obj_to_slab (cache, obj);
+
+  ASSERT (s->free_cnt < cache->objs_per_slab);
+
+  if (s->free_cnt == 0)
+    list_push_front (&cache->slabs, &s->elem);
+  s->free_idx[s->free_cnt++] = (pg_ofs (obj) - cache->obj_ofs)
+                               / cache->obj_size;
+  cache->slab_active--;
+
+  if (s->free_cnt == cache->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      if (cache->empty_cnt > 0)
+        {
+          cache->slab_cnt--;
+          palloc_free_page (s);
+        }
+      else
+        {
+          /* 하나는 남겨 두어 할당과 해제가 반복될 때 page를 매번
+             주고받지 않게 한다. 빈 slab은 list의 뒤에 둔다. */
+          list_push_back (&cache->slabs, &s->elem);
+          cache->empty_cnt++;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* 같은 크기의 kernel 객체들을 위한 object cache.
+   struct kmem_cache의 내용은 slab.c 밖에서 보지 않는다. */
+struct kmem_cache;
+
+/* kmem_cache_get_stats()가 채워주는 cache의 상태. */
+struct kmem_cache_stats
+  {
+    size_t obj_size;            /* 정렬한 객체 크기 (bytes). */
+    size_t objs_per_slab;       /* slab 하나에 들어가는 객체 수. */
+    size_t slab_cnt;            /* 할당받은 slab (page) 수. */
+    size_t active;              /* 사용 중인 객체 수. */
+    size_t alloc_cnt;           /* 지금까지의 할당 횟수. */
+    size_t mag_hits;            /* 그중 magazine에서 바로 준 횟수. */
+  };
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+                                      void (*ctor) (void *));
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_get_stats (struct kmem_cache *, struct kmem_cache_stats *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
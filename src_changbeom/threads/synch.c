@@ -30,9 +30,182 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include <list.h>
+#ifdef LOCK_STAT
+#include <inttypes.h>
+#include "devices/timer.h"
+
+/* synch.h의 macro들 대신 통계 없이 초기화하는 함수를 정의한다. */
+#undef sema_init
+#undef lock_init
+#undef rwlock_init
+
+/* 초기화된 적이 있는 모든 lock_class. */
+static struct list lock_class_list = LIST_INITIALIZER (lock_class_list);
+
+/* lock_stat_print()가 출력하는 class의 최대 수. */
+#define LOCK_STAT_TOP_CNT 10
+
+static void lock_class_register (struct lock_class *);
+static void lock_stat_acquired (struct lock_class *, uint64_t wait_start);
+static void lock_stat_released (struct lock_class *, uint64_t acquired);
+#endif
+/* wait queue 비교 함수. priority가 높은 thread가 top이 되고,
+   priority가 같으면 먼저 들어온 thread가 top이 된다. */
+static bool
+cmp_wait_priority (const struct heap_elem *a_, const struct heap_elem *b_,
+                   void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, wait_elem);
+  const struct thread *b = heap_entry (b_, struct thread, wait_elem);
+
+  if (a->priority != b->priority)
+    return a->priority > b->priority;
+  return (int) (a->wait_seq - b->wait_seq) < 0;
+}
+
+/* Initializes WQ as an empty wait queue. */
+void
+wait_queue_init (struct wait_queue *wq)
+{
+  ASSERT (wq != NULL);
+
+  heap_init (&wq->waiters, cmp_wait_priority, NULL);
+  wq->next_seq = 0;
+  list_init (&wq->holds);
+}
+
+/* Adds thread T to WQ.  T must not be waiting on any other wait
+   queue.  Must be called with interrupts off. */
+void
+wait_queue_push (struct wait_queue *wq, struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->wait_queue == NULL);
+
+  t->wait_queue = wq;
+  t->wait_seq = wq->next_seq++;
+  heap_push (&wq->waiters, &t->wait_elem);
+}
+
+/* Removes the highest-priority thread from WQ, which must not be
+   empty, and returns it.  Must be called with interrupts off. */
+struct thread *
+wait_queue_pop (struct wait_queue *wq)
+{
+  struct thread *t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!wait_queue_empty (wq));
+
+  t = heap_entry (heap_pop (&wq->waiters), struct thread, wait_elem);
+  t->wait_queue = NULL;
+  return t;
+}
+
+/* Moves thread T, which is waiting on a wait queue, to the right
+   place after its priority changed.  Must be called with
+   interrupts off. */
+void
+wait_queue_update (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->wait_queue != NULL);
+
+  heap_update (&t->wait_queue->waiters, &t->wait_elem);
+}
+
+/* Removes thread T from the wait queue it is waiting on.  Must be
+   called with interrupts off. */
+void
+wait_queue_remove (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->wait_queue != NULL);
+
+  heap_remove (&t->wait_queue->waiters, &t->wait_elem);
+  t->wait_queue = NULL;
+}
+
+/* Returns true if no thread is waiting on WQ. */
+bool
+wait_queue_empty (const struct wait_queue *wq)
+{
+  return heap_empty (&wq->waiters);
+}
+
+/* Returns the highest-priority thread waiting on WQ without
+   removing it, or a null pointer if there are none. */
+struct thread *
+wait_queue_top (const struct wait_queue *wq)
+{
+  struct heap_elem *top = heap_top (&wq->waiters);
+
+  if (top == NULL)
+    return NULL;
+  return heap_entry (top, struct thread, wait_elem);
+}
+
+/* Returns the highest priority among the threads waiting on WQ,
+   or PRI_MIN - 1 if there are none. */
+int
+wait_queue_priority (const struct wait_queue *wq)
+{
+  struct thread *top = wait_queue_top (wq);
+
+  if (top == NULL)
+    return PRI_MIN - 1;
+  return top->priority;
+}
+
+/* thread T가 WAITERS에서 기다리는 대상을 점유하기 시작했음을 HOLD에 기록한다.
+   WAITERS에서 기다리는 thread들이 T에게 priority를 donate하게 된다.
+   mlfqs에서는 priority donation을 하지 않으므로 아무것도 하지 않는다. */
+static void
+hold_add (struct lock_hold *hold, struct thread *t, struct wait_queue *waiters)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_mlfqs)
+    return;
+  hold->holder = t;
+  hold->waiters = waiters;
+  list_push_back (&waiters->holds, &hold->list_elem);
+  heap_push (&t->held_locks, &hold->elem);
+  thread_refresh_priority (t);
+}
+
+/* hold_add()로 기록한 HOLD를 지우고 donate받은 priority를 반납한다. */
+static void
+hold_remove (struct lock_hold *hold)
+{
+  struct thread *t = hold->holder;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_mlfqs)
+    return;
+  list_remove (&hold->list_elem);
+  heap_remove (&t->held_locks, &hold->elem);
+  hold->holder = NULL;
+  hold->waiters = NULL;
+  thread_refresh_priority (t);
+}
+
+/* thread의 held_locks heap 비교 함수. 기다리는 thread의 최대 priority가
+   높은 lock_hold가 top이 된다. */
+bool
+cmp_hold_priority (const struct heap_elem *a, const struct heap_elem *b,
+                   void *aux UNUSED)
+{
+  return wait_queue_priority (heap_entry (a, struct lock_hold, elem)->waiters)
+         > wait_queue_priority (heap_entry (b, struct lock_hold, elem)->waiters);
+}
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -42,17 +215,18 @@
 
    - up or "V": increment the value (and wake up one waiting
      thread, if any). */
-struct semaphore_elem;
 void
 sema_init (struct semaphore *sema, unsigned value) 
 {
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  wait_queue_init (&sema->waiters);
+#ifdef LOCK_STAT
+  sema->class = NULL;
+#endif
 }
 
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
    to become positive and then atomically decrements it.
 
@@ -64,21 +238,88 @@ void
 sema_down (struct semaphore *sema) 
 {
   enum intr_level old_level;
+#ifdef LOCK_STAT
+  uint64_t wait_start;
+#endif
 
   ASSERT (sema != NULL);
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
+#ifdef LOCK_STAT
+  wait_start = sema->value == 0 ? timer_tsc () : 0;
+#endif
   while (sema->value == 0) 
     {
-      //list_push_back (&sema->waiters, &thread_current ()->elem);
-      list_insert_ordered (&sema->waiters, &thread_current ()->elem, cmp_priority, NULL);
+      wait_queue_push (&sema->waiters, thread_current ());
       thread_block ();
     }
   sema->value--;
+#ifdef LOCK_STAT
+  lock_stat_acquired (sema->class, wait_start);
+#endif
   intr_set_level (old_level);
 }
 
+/* sema_down()과 같지만 기다리는 도중 *CANCEL이 true가 되면 SEMA를
+   내리지 않고 false를 반환한다. 내렸으면 true를 반환한다.
+   *CANCEL은 interrupt를 끈 채로 true로 바꾸고, 바꾼 쪽은 기다리는
+   thread를 sema_cancel()로 깨워야 한다.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+sema_down_cancelable (struct semaphore *sema, const bool *cancel)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool success = false;
+#ifdef LOCK_STAT
+  uint64_t wait_start;
+#endif
+
+  ASSERT (sema != NULL);
+  ASSERT (cancel != NULL);
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+#ifdef LOCK_STAT
+  wait_start = sema->value == 0 ? timer_tsc () : 0;
+#endif
+  while (sema->value == 0 && !*cancel)
+    {
+      cur->cancel_sema = sema;
+      wait_queue_push (&sema->waiters, cur);
+      thread_block ();
+      cur->cancel_sema = NULL;
+    }
+  if (sema->value > 0)
+    {
+      sema->value--;
+      success = true;
+#ifdef LOCK_STAT
+      lock_stat_acquired (sema->class, wait_start);
+#endif
+    }
+  intr_set_level (old_level);
+  return success;
+}
+
+/* T가 sema_down_cancelable()에서 기다리고 있으면 깨워서 cancel 조건을
+   다시 확인하게 한다. 그 밖의 이유로 block된 thread는 건드리지 않는다.
+   Must be called with interrupts off. */
+void
+sema_cancel (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->cancel_sema != NULL && t->wait_queue == &t->cancel_sema->waiters)
+    {
+      wait_queue_remove (t);
+      thread_unblock (t);
+    }
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -97,6 +338,9 @@ sema_try_down (struct semaphore *sema)
     {
       sema->value--;
       success = true; 
+#ifdef LOCK_STAT
+      lock_stat_acquired (sema->class, 0);
+#endif
     }
   else
     success = false;
@@ -117,14 +361,14 @@ sema_up (struct semaphore *sema)
   ASSERT (sema != NULL);
 
   old_level = intr_disable ();
-  if (!list_empty (&sema->waiters)) {
-    /* 스레드들의 우선순위가 중간에 변경되었을 수도 있으니 다시 정렬한다. */
-    list_sort (&sema->waiters, cmp_priority, NULL); 
-    
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
-
-  }
+  /* wait queue는 항상 우선순위 순서를 유지하므로 top을 깨우면 된다. */
+  if (!wait_queue_empty (&sema->waiters))
+    {
+      struct thread *t = wait_queue_pop (&sema->waiters);
+      trace_event (TRACE_SEMA_WAKE, t->tid, (uintptr_t) sema,
+                   thread_current ()->tid);
+      thread_unblock (t);
+    }
 
   sema->value++;
   /* 우선순위를 고려한 스케줄링을 한다. */
@@ -191,6 +435,9 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+#ifdef LOCK_STAT
+  lock->acquired_tsc = 0;
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -209,18 +456,40 @@ lock_acquire (struct lock *lock)
   ASSERT (!lock_held_by_current_thread (lock));
   struct thread *cur = thread_current ();
   enum intr_level old_level = intr_disable ();
+  bool waited = false;
+#ifdef LOCK_STAT
+  uint64_t wait_start = 0;
+#endif
   
-  if (lock->holder) {
-    cur->wait_on_lock = lock;
-    /* lock을 점유한 thread에게 priority를 donate한다. */
-    list_insert_ordered (&lock->holder->donations, &cur->donation_elem, cmp_priority, NULL);
-    donate_priority ();
+  /* sema_down()과 같지만, semaphore의 wait queue에 들어간 다음
+     block되기 전에 lock을 점유한 thread에게 priority를 donate한다.
+     mlfqs에서는 priority donation을 하지 않는다. */
+  while (lock->semaphore.value == 0) {
+    if (!waited)
+      {
+        trace_event (TRACE_LOCK_WAIT, cur->tid, (uintptr_t) lock,
+                     lock->holder != NULL ? lock->holder->tid : 0);
+#ifdef LOCK_STAT
+        wait_start = timer_tsc ();
+#endif
+      }
+    waited = true;
+    wait_queue_push (&lock->semaphore.waiters, cur);
+    if (!thread_mlfqs)
+      donate_priority ();
+    thread_block ();
   }
+  lock->semaphore.value--;
+  if (waited)
+    trace_event (TRACE_LOCK_ACQUIRE, cur->tid, (uintptr_t) lock, 0);
+#ifdef LOCK_STAT
+  lock_stat_acquired (lock->semaphore.class, wait_start);
+  lock->acquired_tsc = timer_tsc ();
+#endif
   
-  sema_down (&lock->semaphore);
-  
-  cur->wait_on_lock = NULL;
-  lock->holder = thread_current ();
+  lock->holder = cur;
+  /* 아직 lock을 기다리는 thread들의 priority를 새 holder가 donate받는다. */
+  hold_add (&lock->hold, cur, &lock->semaphore.waiters);
   intr_set_level (old_level);
 }
 
@@ -238,9 +507,17 @@ lock_try_acquire (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  enum intr_level old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
-  if (success)
+  if (success) {
+#ifdef LOCK_STAT
+    /* 획득 횟수는 sema_try_down()에서 세었다. */
+    lock->acquired_tsc = timer_tsc ();
+#endif
     lock->holder = thread_current ();
+    hold_add (&lock->hold, lock->holder, &lock->semaphore.waiters);
+  }
+  intr_set_level (old_level);
   return success;
 }
 
@@ -255,9 +532,11 @@ lock_release (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
   enum intr_level old_level = intr_disable ();
+#ifdef LOCK_STAT
+  lock_stat_released (lock->semaphore.class, lock->acquired_tsc);
+#endif
   lock->holder = NULL;
-  remove_with_lock (lock);
-  refresh_priority ();
+  hold_remove (&lock->hold);
   sema_up (&lock->semaphore);
   intr_set_level (old_level);
 }
@@ -272,27 +551,6 @@ lock_held_by_current_thread (const struct lock *lock)
 
   return lock->holder == thread_current ();
 }
-
-/* One semaphore in a list. */
-struct semaphore_elem 
-  {
-    struct list_elem elem;              /* List element. */
-    struct semaphore semaphore;         /* This semaphore. */
-  };
-
-/* 각 semaphore_elem을 지역변수로 갖고있는 thread들의 우선순위를 비교하여
-   첫번째 인자가 더 클경우 true를 반환한다.*/
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-  struct semaphore_elem *sa = list_entry (a, struct semaphore_elem, elem);
-  struct semaphore_elem *sb = list_entry (b, struct semaphore_elem, elem);
-  struct thread *thread_a = (struct thread*)pg_round_down (sa);
-  struct thread *thread_b = (struct thread*)pg_round_down (sb);
-  return thread_a->priority > thread_b->priority;
-}
-
-
-
-
 
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
@@ -302,7 +560,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  wait_queue_init (&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -328,19 +586,23 @@ cond_init (struct condition *cond)
 void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
-  struct semaphore_elem waiter;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
   
-  sema_init (&waiter.semaphore, 0);
-  //list_push_back (&cond->waiters, &waiter.elem);
-  /* 기존의 FIFO로 구현된 대기 큐를 우선순위에 따라 삽입되도록 한다. */
-  list_insert_ordered (&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
+  /* waiter마다 semaphore를 두는 대신 cond의 wait queue에서 직접 기다린다.
+     lock_release()에서 더 높은 우선순위의 thread에게 양보하는 동안
+     signal을 받았다면 wait queue에서 이미 빠져 있으므로 block하지 않는다. */
+  old_level = intr_disable ();
+  wait_queue_push (&cond->waiters, cur);
   lock_release (lock);
-  sema_down (&waiter.semaphore);
+  if (cur->wait_queue != NULL)
+    thread_block ();
+  intr_set_level (old_level);
   lock_acquire (lock);
 }
 
@@ -359,11 +621,18 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters))
-    /* 대기 큐가 중간에 스레드의 우선순위가 바뀌어있을 수도 있으므로 재정렬한다. */
-    list_sort (&cond->waiters, cmp_sem_priority, NULL);
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+  enum intr_level old_level = intr_disable ();
+  if (!wait_queue_empty (&cond->waiters))
+    {
+      struct thread *t = wait_queue_pop (&cond->waiters);
+
+      /* cond_wait()에서 아직 block되기 전이라면 wait queue에서 빼는 것만으로
+         signal이 전달된다. */
+      if (t->status == THREAD_BLOCKED)
+        thread_unblock (t);
+      test_max_priority ();
+    }
+  intr_set_level (old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -378,6 +647,409 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!wait_queue_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* rwlock을 읽기로 점유한 thread마다 하나씩 쓰는 lock_hold들의 cache.
+   thread가 동시에 읽기로 점유하는 rwlock 수만큼만 할당되므로 struct
+   thread에 자리를 잡아 두지 않는다. */
+static struct kmem_cache *read_hold_cache;
+
+/* rwlock이 reader에게 쓸 lock_hold cache를 만든다.
+   malloc_init() 뒤, rwlock을 읽기로 처음 점유하기 전에 호출해야 한다. */
+void
+rwlock_cache_init (void)
+{
+  read_hold_cache = kmem_cache_create ("read_hold", sizeof (struct lock_hold),
+                                       NULL);
+  if (read_hold_cache == NULL)
+    PANIC ("rwlock_cache_init: out of memory");
+}
+
+/* Initializes RW as an unlocked reader-writer lock. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  wait_queue_init (&rw->waiters);
+  rw->readers = 0;
+  rw->writer = NULL;
+#ifdef LOCK_STAT
+  rw->class = NULL;
+  rw->write_tsc = 0;
+#endif
+}
+
+/* thread T에게 RW를 읽기 또는 쓰기(WRITE)로 점유시킨다. */
+static void
+rwlock_grant (struct rwlock *rw, struct thread *t, bool write)
+{
+  if (write)
+    {
+      rw->writer = t;
+      hold_add (&rw->writer_hold, t, &rw->waiters);
+    }
+  else
+    {
+      rw->readers++;
+      if (t->rw_hold != NULL)
+        {
+          hold_add (t->rw_hold, t, &rw->waiters);
+          t->rw_hold = NULL;
+        }
+    }
+}
+
+/* RW가 비었을 때 기다리는 thread들에게 넘겨준다. 가장 높은 우선순위의
+   thread가 writer면 그 writer만 깨우고, reader면 다음 writer가 나올 때까지
+   reader들을 깨운다. 깨어난 thread는 이미 RW를 점유한 상태이다. */
+static void
+rwlock_wake (struct rwlock *rw)
+{
+  struct thread *t;
+
+  struct list_elem *e;
+
+  while ((t = wait_queue_top (&rw->waiters)) != NULL)
+    {
+      if (t->rw_write && (rw->readers > 0 || rw->writer != NULL))
+        break;
+      wait_queue_pop (&rw->waiters);
+      rwlock_grant (rw, t, t->rw_write);
+      thread_unblock (t);
+      if (t->rw_write)
+        break;
+    }
+
+  /* 기다리는 thread가 빠졌으므로 먼저 깨어난 reader들이 donate받던
+     priority가 낮아졌을 수 있다. held_locks heap 위치를 다시 맞춘다. */
+  if (thread_mlfqs)
+    return;
+  for (e = list_begin (&rw->waiters.holds); e != list_end (&rw->waiters.holds);
+       e = list_next (e))
+    {
+      struct lock_hold *hold = list_entry (e, struct lock_hold, list_elem);
+
+      heap_update (&hold->holder->held_locks, &hold->elem);
+      thread_refresh_priority (hold->holder);
+    }
+}
+
+/* 현재 thread가 RW를 읽기로 점유하면서 기록한 lock_hold를 반환한다.
+   없으면 null pointer를 반환한다. mlfqs이거나 lock_hold를 할당하지
+   못했다면 기록하지 않았으므로 null pointer를 반환한다. */
+static struct lock_hold *
+rwlock_read_hold (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&rw->waiters.holds); e != list_end (&rw->waiters.holds);
+       e = list_next (e))
+    {
+      struct lock_hold *hold = list_entry (e, struct lock_hold, list_elem);
+
+      if (hold->holder == cur && hold != &rw->writer_hold)
+        return hold;
+    }
+  return NULL;
+}
+
+/* 현재 thread가 RW를 WRITE 모드로 점유할 때까지 기다린다.
+   기다리는 동안 RW를 점유한 모든 thread에게 priority를 donate한다. */
+static void
+rwlock_wait (struct rwlock *rw, bool write)
+{
+  struct thread *cur = thread_current ();
+
+  cur->rw_write = write;
+  wait_queue_push (&rw->waiters, cur);
+  if (!thread_mlfqs)
+    donate_priority ();
+  thread_block ();
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it
+   and no writer is waiting for it.  Any number of threads may
+   hold RW for reading at once, but a thread may hold it for
+   reading only once: with a writer waiting, a nested acquire
+   would wait for the thread itself.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != thread_current ());
+
+  /* 점유한 뒤 priority를 donate받는 데 쓸 lock_hold를 미리 할당한다.
+     cache에서 lock을 얻어야 할 수도 있으므로 interrupt를 끄기 전에
+     할당한다. 할당하지 못하면 donation 없이 점유한다. */
+  if (!thread_mlfqs)
+    thread_current ()->rw_hold = kmem_cache_alloc (read_hold_cache);
+
+  old_level = intr_disable ();
+  ASSERT (rwlock_read_hold (rw) == NULL);
+  /* 기다리는 writer가 있으면 새 reader도 뒤에서 기다려서
+     writer가 계속 밀려나지 않도록 한다. */
+  if (rw->writer == NULL && wait_queue_empty (&rw->waiters))
+    {
+      rwlock_grant (rw, thread_current (), false);
+#ifdef LOCK_STAT
+      lock_stat_acquired (rw->class, 0);
+#endif
+    }
+  else
+    {
+#ifdef LOCK_STAT
+      uint64_t wait_start = timer_tsc ();
+#endif
+      rwlock_wait (rw, false);
+#ifdef LOCK_STAT
+      lock_stat_acquired (rw->class, wait_start);
+#endif
+    }
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  struct lock_hold *hold;
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (rw->readers > 0);
+
+  old_level = intr_disable ();
+  rw->readers--;
+  hold = rwlock_read_hold (rw);
+  if (hold != NULL)
+    hold_remove (hold);
+  if (rw->readers == 0)
+    rwlock_wake (rw);
+  test_max_priority ();
+  intr_set_level (old_level);
+
+  if (hold != NULL)
+    kmem_cache_free (read_hold_cache, hold);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not hold RW for reading, since it
+   would then wait for itself forever.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != thread_current ());
+
+  old_level = intr_disable ();
+  ASSERT (rwlock_read_hold (rw) == NULL);
+  if (rw->writer == NULL && rw->readers == 0)
+    {
+      rwlock_grant (rw, thread_current (), true);
+#ifdef LOCK_STAT
+      lock_stat_acquired (rw->class, 0);
+#endif
+    }
+  else
+    {
+#ifdef LOCK_STAT
+      uint64_t wait_start = timer_tsc ();
+#endif
+      rwlock_wait (rw, true);
+#ifdef LOCK_STAT
+      lock_stat_acquired (rw->class, wait_start);
+#endif
+    }
+#ifdef LOCK_STAT
+  rw->write_tsc = timer_tsc ();
+#endif
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_held_by_current_thread (rw));
+
+  old_level = intr_disable ();
+#ifdef LOCK_STAT
+  lock_stat_released (rw->class, rw->write_tsc);
+#endif
+  rw->writer = NULL;
+  hold_remove (&rw->writer_hold);
+  rwlock_wake (rw);
+  test_max_priority ();
+  intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+#ifdef LOCK_STAT
+/* SEMA를 VALUE로 초기화하고 경합 통계를 CLASS에 모은다. */
+void
+sema_init_class (struct semaphore *sema, unsigned value,
+                 struct lock_class *class)
+{
+  sema_init (sema, value);
+  sema->class = class;
+  lock_class_register (class);
+}
+
+/* LOCK을 초기화하고 경합 통계를 CLASS에 모은다. */
+void
+lock_init_class (struct lock *lock, struct lock_class *class)
+{
+  lock_init (lock);
+  lock->semaphore.class = class;
+  lock_class_register (class);
+}
+
+/* RW를 초기화하고 경합 통계를 CLASS에 모은다.
+   점유한 시간은 쓰기로 점유한 시간만 센다. */
+void
+rwlock_init_class (struct rwlock *rw, struct lock_class *class)
+{
+  rwlock_init (rw);
+  rw->class = class;
+  lock_class_register (class);
+}
+
+/* CLASS가 처음 사용되면 lock_class_list에 넣는다. */
+static void
+lock_class_register (struct lock_class *class)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (!class->registered)
+    {
+      class->registered = true;
+      list_push_back (&lock_class_list, &class->elem);
+    }
+  intr_set_level (old_level);
+}
+
+/* CLASS의 객체를 한 번 획득했음을 기록한다. 기다려야 했다면
+   WAIT_START는 기다리기 시작한 시각이고, 아니면 0이다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+lock_stat_acquired (struct lock_class *class, uint64_t wait_start)
+{
+  if (class == NULL)
+    return;
+
+  class->acquired++;
+  if (wait_start != 0)
+    {
+      uint64_t wait = timer_tsc () - wait_start;
+
+      class->contended++;
+      class->wait_total += wait;
+      if (wait > class->wait_max)
+        class->wait_max = wait;
+    }
+}
+
+/* ACQUIRED 시각에 획득한 CLASS의 객체를 놓았음을 기록한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+lock_stat_released (struct lock_class *class, uint64_t acquired)
+{
+  uint64_t hold;
+
+  if (class == NULL || acquired == 0)
+    return;
+
+  hold = timer_tsc () - acquired;
+  class->hold_total += hold;
+  if (hold > class->hold_max)
+    class->hold_max = hold;
+}
+
+/* 경합이 더 많았던 class가 앞에 오도록 비교한다.
+   경합 횟수가 같으면 기다린 시간의 합이 큰 class가 앞이다. */
+static bool
+lock_class_more_contended (const struct list_elem *a_,
+                           const struct list_elem *b_, void *aux UNUSED)
+{
+  const struct lock_class *a = list_entry (a_, struct lock_class, elem);
+  const struct lock_class *b = list_entry (b_, struct lock_class, elem);
+
+  if (a->contended != b->contended)
+    return a->contended > b->contended;
+  return a->wait_total > b->wait_total;
+}
+
+/* TSC cycle 수 CYCLES를 microsecond로 바꾼다. */
+static uint64_t
+cycles_to_us (uint64_t cycles)
+{
+  uint64_t hz = timer_tsc_hz ();
+
+  return hz != 0 ? cycles * 1000000 / hz : 0;
+}
+
+/* 경합이 가장 많았던 lock_class들의 통계를 출력한다.
+   시간은 microsecond 단위이다. */
+void
+lock_stat_print (void)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+  int i = 0;
+
+  old_level = intr_disable ();
+  list_sort (&lock_class_list, lock_class_more_contended, NULL);
+  intr_set_level (old_level);
+
+  printf ("Lock contention: %zu classes, most contended (times in us):\n",
+          list_size (&lock_class_list));
+  printf ("  KIND   NAME                 ACQUIRED CONTENDED  WAIT-AVG  WAIT-MAX"
+          "  HOLD-AVG  HOLD-MAX  WHERE\n");
+  for (e = list_begin (&lock_class_list);
+       e != list_end (&lock_class_list) && i < LOCK_STAT_TOP_CNT;
+       e = list_next (e), i++)
+    {
+      const struct lock_class *c = list_entry (e, struct lock_class, elem);
+      const char *file = c->file;
+
+      /* 빌드 디렉터리 기준의 "../../"를 뗀다. */
+      while (file[0] == '.' && file[1] == '.' && file[2] == '/')
+        file += 3;
+      printf ("  %-6s %-20s %8u %9u %9"PRIu64" %9"PRIu64
+              " %9"PRIu64" %9"PRIu64"  %s:%d\n",
+              c->kind, c->name, c->acquired, c->contended,
+              c->contended != 0 ? cycles_to_us (c->wait_total) / c->contended : 0,
+              cycles_to_us (c->wait_max),
+              c->acquired != 0 ? cycles_to_us (c->hold_total) / c->acquired : 0,
+              cycles_to_us (c->hold_max), file, c->line);
+    }
+}
+#endif /* LOCK_STAT */
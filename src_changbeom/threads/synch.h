@@ -2,18 +2,90 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <heap.h>
 #include <stdbool.h>
+#include <stdint.h>
 
+struct thread;
+
+#ifdef LOCK_STAT
+/* Lock 경합 통계. "make LOCK_STAT=1"로 빌드했을 때만 포함된다.
+   sema_init(), lock_init(), rwlock_init()을 호출하는 곳마다 static
+   lock_class가 하나씩 만들어지고, 그곳에서 초기화한 객체들의 통계가
+   모두 여기에 더해진다. 따라서 malloc의 desc마다 있는 lock처럼 한 곳에서
+   초기화하는 여러 객체는 하나로 합쳐지며, 객체가 해제되어도 통계는
+   남는다. 시간은 TSC cycle 단위이다. */
+struct lock_class
+  {
+    const char *kind;           /* "sema", "lock" 또는 "rwlock". */
+    const char *name;           /* 초기화 함수에 넘긴 식. */
+    const char *file;           /* 초기화한 파일. */
+    int line;                   /* 초기화한 줄. */
+    bool registered;            /* lock_class_list에 들어 있으면 true. */
+    struct list_elem elem;      /* lock_class_list element. */
+    unsigned acquired;          /* 획득한 횟수. */
+    unsigned contended;         /* 기다려야 했던 횟수. */
+    uint64_t wait_total;        /* 기다린 시간의 합. */
+    uint64_t wait_max;          /* 가장 오래 기다린 시간. */
+    uint64_t hold_total;        /* 점유한 시간의 합. */
+    uint64_t hold_max;          /* 가장 오래 점유한 시간. */
+  };
+
+#define LOCK_CLASS_INITIALIZER(KIND, NAME) \
+  { KIND, NAME, __FILE__, __LINE__, false, { NULL, NULL }, 0, 0, 0, 0, 0, 0 }
+
+void lock_stat_print (void);
+#endif
+
+/* 우선순위 wait queue.
+   기다리는 thread들을 우선순위 max heap으로 관리하고, 같은 우선순위끼리는
+   먼저 들어온 thread가 먼저 나온다. donation 등으로 기다리는 thread의
+   우선순위가 바뀌면 thread_change_priority()가 wait_queue_update()로
+   heap 안의 위치를 고쳐주므로 깨울 때 다시 정렬할 필요가 없다. */
+struct wait_queue
+  {
+    struct heap waiters;        /* Waiting threads. */
+    unsigned next_seq;          /* 다음에 들어올 thread의 순번. */
+    struct list holds;          /* 기다리는 대상을 점유한 thread들의 lock_hold. */
+  };
+
+void wait_queue_init (struct wait_queue *);
+void wait_queue_push (struct wait_queue *, struct thread *);
+struct thread *wait_queue_pop (struct wait_queue *);
+void wait_queue_update (struct thread *);
+void wait_queue_remove (struct thread *);
+bool wait_queue_empty (const struct wait_queue *);
+struct thread *wait_queue_top (const struct wait_queue *);
+int wait_queue_priority (const struct wait_queue *);
+
+/* 스레드 하나가 lock이나 rwlock을 점유하고 있음을 나타낸다.
+   점유한 스레드의 held_locks heap에 들어가며, 그 lock의 wait queue에서
+   기다리는 thread들의 최대 priority를 점유한 스레드에게 donate한다.
+   rwlock을 읽기로 점유한 스레드가 여럿이면 lock_hold도 여럿이 된다. */
+struct lock_hold
+  {
+    struct heap_elem elem;      /* holder의 held_locks heap element. */
+    struct list_elem list_elem; /* waiters->holds list element. */
+    struct thread *holder;      /* 점유한 thread. */
+    struct wait_queue *waiters; /* donate해주는 thread들의 wait queue. */
+  };
+
+bool cmp_hold_priority (const struct heap_elem *a, const struct heap_elem *b, void *aux);
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */
+    struct wait_queue waiters;  /* Waiting threads. */
+#ifdef LOCK_STAT
+    struct lock_class *class;   /* 경합 통계, 없으면 NULL. */
+#endif
   };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_cancelable (struct semaphore *, const bool *cancel);
+void sema_cancel (struct thread *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
@@ -23,18 +95,21 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct lock_hold hold;      /* holder가 점유하고 있음을 나타냄. */
+#ifdef LOCK_STAT
+    uint64_t acquired_tsc;      /* holder가 lock을 얻은 시각. */
+#endif
   };
-struct semaphore_elem; 
 void lock_init (struct lock *);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
+
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct wait_queue waiters;  /* Waiting threads. */
   };
 
 void cond_init (struct condition *);
@@ -42,6 +117,63 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock.
+   여러 thread가 읽기(shared)로, 한 thread만 쓰기(exclusive)로 점유할 수 있다.
+   기다리는 writer가 있으면 새 reader도 기다리게 하여 writer starvation을 막고,
+   기다리는 thread들은 점유한 모든 reader 또는 writer에게 priority를 donate한다. */
+struct rwlock
+  {
+    struct wait_queue waiters;  /* Waiting readers and writers. */
+    unsigned readers;           /* 읽기로 점유한 thread 수. */
+    struct thread *writer;      /* 쓰기로 점유한 thread, 없으면 NULL. */
+    struct lock_hold writer_hold; /* writer가 점유하고 있음을 나타냄. */
+#ifdef LOCK_STAT
+    struct lock_class *class;   /* 경합 통계, 없으면 NULL. */
+    uint64_t write_tsc;         /* writer가 쓰기로 점유한 시각. */
+#endif
+  };
+
+void rwlock_cache_init (void);
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
+#ifdef LOCK_STAT
+void sema_init_class (struct semaphore *, unsigned value, struct lock_class *);
+void lock_init_class (struct lock *, struct lock_class *);
+void rwlock_init_class (struct rwlock *, struct lock_class *);
+
+/* 초기화하는 곳마다 lock_class를 하나씩 만들어서 넘긴다.
+   threads/synch.c는 이 macro들 대신 같은 이름의 함수를 정의한다. */
+#define sema_init(SEMA, VALUE)                                          \
+  do                                                                    \
+    {                                                                   \
+      static struct lock_class sema_class_ =                            \
+        LOCK_CLASS_INITIALIZER ("sema", #SEMA);                         \
+      sema_init_class (SEMA, VALUE, &sema_class_);                      \
+    }                                                                   \
+  while (0)
+#define lock_init(LOCK)                                                 \
+  do                                                                    \
+    {                                                                   \
+      static struct lock_class lock_class_ =                            \
+        LOCK_CLASS_INITIALIZER ("lock", #LOCK);                         \
+      lock_init_class (LOCK, &lock_class_);                             \
+    }                                                                   \
+  while (0)
+#define rwlock_init(RW)                                                 \
+  do                                                                    \
+    {                                                                   \
+      static struct lock_class rwlock_class_ =                          \
+        LOCK_CLASS_INITIALIZER ("rwlock", #RW);                         \
+      rwlock_init_class (RW, &rwlock_class_);                           \
+    }                                                                   \
+  while (0)
+#endif
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -11,6 +11,11 @@
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/fixed_point.h"
+#include "threads/fpu.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -24,18 +29,77 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* THREAD_READY 상태인 프로세스들을 우선순위별로 관리하는 run queue.
+   우선순위 하나당 FIFO 리스트 하나를 두고, 비어있지 않은 리스트를
+   64비트 bitmap으로 표시하여 가장 높은 우선순위를 상수 시간에 찾는다.
+   bitmap의 i번째 비트는 우선순위 (PRI_MAX - i)에 해당하므로,
+   가장 낮은 set bit (find-first-set)가 가장 높은 우선순위가 된다. */
+#define READY_QUEUE_CNT (PRI_MAX - PRI_MIN + 1)
+static struct list ready_queue[READY_QUEUE_CNT];
+static uint64_t ready_bitmap;
+
+/* ready queue에 들어있는 스레드의 수. load_avg 계산에 사용한다. */
+static size_t ready_thread_cnt;
+
+/* cfs 모드의 run queue. vruntime이 가장 작은 스레드가 top이다.
+   cfs_load는 그 안에 있는 스레드들의 가중치 합이고, cfs_min_vruntime은
+   run queue와 실행 중인 스레드의 vruntime 중 최소값을 단조 증가하게
+   따라가며, 새로 들어오는 스레드의 vruntime 기준점이 된다. */
+static struct heap cfs_queue;
+static int64_t cfs_load;
+static int64_t cfs_min_vruntime;
+
+/* cfs의 스케줄링 주기. runnable 스레드들이 이 시간 안에 한 번씩 실행되도록
+   가중치에 비례해서 time slice를 나눈다. 스레드가 많아서 한 스레드의 몫이
+   CFS_MIN_GRAN_NS보다 작아지면 주기를 늘린다. timer tick보다 짧은
+   slice는 강제할 수 없으므로 최소 단위는 tick 하나이다. */
+#define CFS_LATENCY_NS (40 * 1000 * 1000)
+#define CFS_MIN_GRAN_NS (1000 * 1000 * 1000 / TIMER_FREQ)
+
+/* 깨어난 스레드는 cfs_min_vruntime보다 최대 이만큼 작은 vruntime을 받아서
+   CPU를 오래 쓴 스레드들보다 먼저 실행된다. */
+#define CFS_SLEEPER_CREDIT_NS (CFS_LATENCY_NS / 2)
+
+/* 깨어난 스레드의 vruntime이 실행 중인 스레드보다 이만큼 이상 작아야
+   선점한다. 너무 잦은 context switch를 막는다. */
+#define CFS_WAKEUP_GRAN_NS (1000 * 1000)
+
+/* nice 값별 가중치. nice 0이 1024이고, nice가 1 작아질 때마다 CPU를
+   약 1.25배 더 받는다. nice 20은 표를 같은 비율로 이어서 정했다. */
+#define CFS_NICE_0_WEIGHT 1024
+static const int cfs_weights[NICE_MAX - NICE_MIN + 1] =
+  {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+    /*  20 */    12,
+  };
+
+/* EDF 스레드들의 run queue. 절대 deadline이 가장 이른 스레드가 top이며,
+   다른 스케줄링 클래스의 ready queue보다 먼저 확인한다. */
+static struct heap edf_queue;
+
+/* 받아들인 EDF 스레드들의 CPU 사용률 합. 1/1000 단위이다.
+   EDF는 사용률 합이 100% 이하이면 모든 deadline을 지킬 수 있지만,
+   interrupt 처리와 다른 스레드들을 위해 EDF_UTIL_MAX까지만 받아들인다. */
+#define EDF_UTIL_MAX 950
+static int edf_util;
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
-/* sleep된 프로세스 구조체들을 관리하는 리스트. alarm clock 구현시 사용 */
-static struct list sleep_list;
+/* sleep된 프로세스 구조체들을 wakeup_tick 순서로 관리하는 min heap.
+   alarm clock 구현시 사용. 삽입과 깨우기가 O(log n)이므로 
+   timer interrupt에서 sleep 중인 스레드 전체를 순회하지 않는다. */
+static struct heap sleep_heap;
 
-/* sleep_list 에 저장된 프로세스 wakeup_tick 시간 중 가장 작은 것을 저장.
+/* sleep_heap 에 저장된 프로세스 wakeup_tick 시간 중 가장 작은 것을 저장.
    초기 값으로 가장 큰 숫자인 INT64_MAX 넣어줌 */
 int64_t next_tick_to_awake = INT32_MAX;
 
@@ -45,6 +109,59 @@ static struct thread *idle_thread;
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
+/* mlfqs에서 사용하는 시스템 평균 부하. 17.14 고정 소수점 형식이다. */
+static int load_avg;
+
+/* 마지막 우선순위 재계산 이후 recent_cpu가 바뀐 스레드들의 리스트.
+   4 tick마다 all_list 전체가 아닌 이 리스트만 순회하면 된다. */
+static struct list mlfqs_dirty_list;
+
+/* 1초마다 모든 스레드의 recent_cpu와 우선순위를 다시 계산하는 work.
+   timer interrupt에서 all_list 전체를 순회하지 않도록 system_wq에서
+   MLFQS_BATCH개씩 나누어 계산한다. mlfqs_epoch는 재계산할 때마다 1씩
+   늘어나며, 이번 재계산에서 이미 계산한 스레드를 구분하는 데 사용한다. */
+#define MLFQS_BATCH 8
+static struct work mlfqs_work;
+static unsigned mlfqs_epoch;
+
+/* 재사용하기 위해 모아둔 page들의 최대 개수. */
+#define PAGE_CACHE_MAX 32
+
+/* 반환된 thread page와 FDT page를 palloc에 돌려주지 않고 모아두는 cache.
+   palloc_get_page()는 pool lock을 잡고 bitmap을 검색한 뒤 PAL_ZERO로
+   page 전체를 0으로 채우지만, cache에서 꺼낸 page는 필요한 부분만 초기화한다.
+   interrupt를 끈 상태로만 접근하므로 thread_schedule_tail()에서도 쓸 수 있다. */
+static struct list page_cache;
+static size_t page_cache_cnt;
+
+/* cache가 가득 차서 palloc에 돌려줘야 할 page들.
+   thread_schedule_tail()에서는 lock을 잡을 수 없으므로
+   thread_reap()이 나중에 한꺼번에 반환한다. */
+static struct list reap_list;
+
+/* cache와 reap_list에 들어있는 page의 앞부분. */
+struct cached_page
+  {
+    struct list_elem elem;
+  };
+
+/* 커널 스택에서 아직 사용하지 않은 부분을 채워두는 값.
+   스레드가 종료될 때 이 값이 남아 있지 않은 가장 낮은 주소까지를
+   스택이 사용된 깊이로 본다. */
+#define STACK_CANARY 0x57ac57ac
+
+/* 스레드 이름별 커널 스택 최대 사용량. 표가 가득 차면 나머지 이름들은
+   마지막 칸에 합친다. interrupt가 꺼진 상태로만 접근한다. */
+#define STACK_STAT_CNT 32
+struct stack_stat
+  {
+    char name[16];              /* 스레드 이름. */
+    unsigned threads;           /* 기록된 스레드 수. */
+    size_t max_used;            /* 가장 깊이 사용한 스택의 크기. */
+  };
+static struct stack_stat stack_stats[STACK_STAT_CNT];
+static int stack_stat_cnt;
+
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
@@ -70,6 +187,10 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler.
+   Controlled by kernel command-line option "-cfs". */
+bool thread_cfs;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -83,9 +204,45 @@ void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
 void test_max_priority (void); 
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) ;
-void remove_with_lock (struct lock *lock);
 void donate_priority (void);
 void refresh_priority (void); 
+static void donate_to_holders (struct thread *t, int depth);
+static void ready_queue_push (struct thread *t);
+static void ready_queue_remove (struct thread *t);
+static struct thread *ready_queue_pop (void);
+static int ready_queue_max_priority (void);
+static void thread_change_priority (struct thread *t, int priority);
+static bool cmp_wakeup_tick (const struct heap_elem *a,
+                             const struct heap_elem *b, void *aux UNUSED);
+static void mlfqs_priority (struct thread *t);
+static void mlfqs_recent_cpu (struct thread *t);
+static void mlfqs_load_avg (int ready_threads);
+static void mlfqs_increment (void);
+static void mlfqs_recalc (void);
+static int mlfqs_recalc_batch (unsigned epoch, int max);
+static void mlfqs_recalc_work (void *aux);
+static void mlfqs_recalc_dirty (void);
+static void thread_stat_update (struct thread *t);
+static int cfs_weight (const struct thread *t);
+static bool cmp_vruntime (const struct heap_elem *a,
+                          const struct heap_elem *b, void *aux UNUSED);
+static void cfs_update_curr (struct thread *t);
+static void cfs_place (struct thread *t);
+static int64_t cfs_slice (const struct thread *t);
+static bool cfs_should_preempt (struct thread *cur);
+static tid_t do_thread_create (const char *name, int priority,
+                               int64_t period, int64_t budget,
+                               thread_func *, void *aux);
+static void stack_fill (struct thread *t);
+static size_t stack_used (const struct thread *t);
+static void stack_stat_add (struct stack_stat *stats, int *cnt,
+                            const struct thread *t);
+static bool cmp_deadline (const struct heap_elem *a,
+                          const struct heap_elem *b, void *aux UNUSED);
+static int edf_utilization (int64_t period, int64_t budget);
+static int64_t edf_next_job (struct thread *t, int64_t now);
+static void edf_throttle (struct thread *t);
+static bool edf_should_preempt (struct thread *cur);
 
  /*  두 elem을 각각 포함하는 thread의 priority를 비교해주는 함수이다.
   list_insert_ordered, list_sort 등에서 사용된다 */
@@ -97,99 +254,556 @@ bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *a
   return thread_a->priority > thread_b->priority;
 }
 
+/* 우선순위 PRIORITY에 해당하는 ready_bitmap의 비트 마스크를 반환한다. */
+static inline uint64_t
+ready_bit (int priority)
+{
+  return (uint64_t) 1 << (PRI_MAX - priority);
+}
+
+/* thread T를 자신의 우선순위에 해당하는 ready queue의 맨 뒤에 넣고,
+   bitmap에 해당 우선순위가 비어있지 않음을 표시한다.
+   EDF 스레드는 deadline 순서의 edf_queue에, cfs 모드에서는
+   vruntime 순서의 cfs_queue에 넣는다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+ready_queue_push (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+  if (t->edf_period != 0)
+    heap_push (&edf_queue, &t->edf_elem);
+  else if (thread_cfs)
+    {
+      heap_push (&cfs_queue, &t->cfs_elem);
+      cfs_load += cfs_weight (t);
+    }
+  else
+    {
+      list_push_back (&ready_queue[t->priority], &t->elem);
+      ready_bitmap |= ready_bit (t->priority);
+    }
+  ready_thread_cnt++;
+}
+
+/* ready queue에 들어있는 thread T를 꺼낸다. T가 마지막 원소였다면
+   bitmap에서 해당 우선순위의 비트를 지운다. */
+static void
+ready_queue_remove (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_READY);
+
+  if (t->edf_period != 0)
+    heap_remove (&edf_queue, &t->edf_elem);
+  else if (thread_cfs)
+    {
+      heap_remove (&cfs_queue, &t->cfs_elem);
+      cfs_load -= cfs_weight (t);
+    }
+  else
+    {
+      list_remove (&t->elem);
+      if (list_empty (&ready_queue[t->priority]))
+        ready_bitmap &= ~ready_bit (t->priority);
+    }
+  ready_thread_cnt--;
+}
+
+/* ready queue에 있는 thread들 중 가장 높은 우선순위를 반환한다.
+   ready queue가 비어있으면 PRI_MIN - 1을 반환한다.
+   64비트 bitmap을 32비트씩 나눠 ffs로 첫번째 set bit를 찾으므로
+   runnable thread 수와 관계없이 상수 시간에 동작한다. */
+static int
+ready_queue_max_priority (void)
+{
+  uint32_t lo = (uint32_t) ready_bitmap;
+  uint32_t hi = (uint32_t) (ready_bitmap >> 32);
+
+  if (lo != 0)
+    return PRI_MAX - (__builtin_ffs (lo) - 1);
+  else if (hi != 0)
+    return PRI_MAX - (__builtin_ffs (hi) - 1 + 32);
+  else
+    return PRI_MIN - 1;
+}
+
+/* 가장 높은 우선순위의 ready queue에서 가장 먼저 들어온 thread를
+   꺼내서 반환한다. cfs 모드에서는 vruntime이 가장 작은 thread를 꺼낸다.
+   ready 상태인 EDF 스레드가 있으면 deadline이 가장 이른 스레드가 먼저이다.
+   ready queue가 비어있으면 NULL을 반환한다. */
+static struct thread *
+ready_queue_pop (void)
+{
+  int priority = ready_queue_max_priority ();
+  struct thread *t;
+
+  if (!heap_empty (&edf_queue))
+    {
+      t = heap_entry (heap_top (&edf_queue), struct thread, edf_elem);
+      ready_queue_remove (t);
+      return t;
+    }
+
+  if (thread_cfs)
+    {
+      if (heap_empty (&cfs_queue))
+        return NULL;
+      t = heap_entry (heap_top (&cfs_queue), struct thread, cfs_elem);
+      ready_queue_remove (t);
+      return t;
+    }
+
+  if (priority < PRI_MIN)
+    return NULL;
+
+  t = list_entry (list_front (&ready_queue[priority]), struct thread, elem);
+  ready_queue_remove (t);
+  return t;
+}
+
+/* thread T의 우선순위를 PRIORITY로 바꾼다. T가 ready queue에 있다면
+   새 우선순위의 queue로 옮겨 run queue의 순서가 유지되도록 한다.
+   donation에 의해 다른 thread의 우선순위를 바꿀 때도 사용된다. */
+static void
+thread_change_priority (struct thread *t, int priority)
+{
+  enum intr_level old_level;
+
+  if (t->priority == priority)
+    return;
+
+  old_level = intr_disable ();
+  if (t->status == THREAD_READY)
+    {
+      ready_queue_remove (t);
+      t->priority = priority;
+      ready_queue_push (t);
+    }
+  else
+    t->priority = priority;
+
+  /* 기다리고 있는 wait queue 안에서의 위치도 바뀐 우선순위에 맞춘다.
+     cond_wait()에서는 block되기 전에 READY 상태로 wait queue에 있을 수 있다. */
+  if (t->wait_queue != NULL)
+    wait_queue_update (t);
+  intr_set_level (old_level);
+}
+
+/* cfs에서 스레드 T의 nice 값에 해당하는 가중치를 반환한다. */
+static int
+cfs_weight (const struct thread *t)
+{
+  return cfs_weights[t->nice - NICE_MIN];
+}
+
+/* cfs_queue에서 vruntime이 더 작은 thread가 앞에 오도록 비교하는 함수이다. */
+static bool
+cmp_vruntime (const struct heap_elem *a, const struct heap_elem *b,
+              void *aux UNUSED)
+{
+  struct thread *thread_a = heap_entry (a, struct thread, cfs_elem);
+  struct thread *thread_b = heap_entry (b, struct thread, cfs_elem);
+
+  return thread_a->vruntime < thread_b->vruntime;
+}
+
+/* 실행 중인 스레드 T가 exec_start 이후 실행한 시간을 T의 vruntime과
+   slice_exec에 반영하고, cfs_min_vruntime을 갱신한다.
+   vruntime은 가중치에 반비례하게 늘어나므로 가중치가 큰 스레드일수록
+   같은 vruntime 동안 CPU를 더 오래 쓴다. */
+static void
+cfs_update_curr (struct thread *t)
+{
+  enum intr_level old_level;
+  int64_t now, delta, min;
+
+  if (!thread_cfs || t == idle_thread || t->edf_period != 0)
+    return;
+
+  old_level = intr_disable ();
+  now = timer_ns ();
+  delta = now - t->exec_start;
+  if (delta > 0)
+    {
+      t->exec_start = now;
+      t->slice_exec += delta;
+      t->vruntime += delta * CFS_NICE_0_WEIGHT / cfs_weight (t);
+    }
+
+  min = t->vruntime;
+  if (!heap_empty (&cfs_queue))
+    {
+      int64_t top = heap_entry (heap_top (&cfs_queue), struct thread,
+                                cfs_elem)->vruntime;
+      if (top < min)
+        min = top;
+    }
+  if (min > cfs_min_vruntime)
+    cfs_min_vruntime = min;
+  intr_set_level (old_level);
+}
+
+/* 깨어난 스레드 T의 vruntime을 정한다. 오래 잠들어 있던 스레드가
+   그동안 쌓인 차이만큼 CPU를 독점하지 않도록 cfs_min_vruntime에서
+   CFS_SLEEPER_CREDIT_NS를 뺀 값보다 작아지지 않게 한다.
+   짧게 잠든 스레드는 원래의 vruntime을 유지한다. */
+static void
+cfs_place (struct thread *t)
+{
+  int64_t floor = cfs_min_vruntime - CFS_SLEEPER_CREDIT_NS;
+
+  if (t->vruntime < floor)
+    t->vruntime = floor;
+}
+
+/* 실행 중인 스레드 T가 한 번에 실행할 수 있는 시간을 반환한다.
+   스케줄링 주기를 runnable 스레드들의 가중치 비율로 나눈다. */
+static int64_t
+cfs_slice (const struct thread *t)
+{
+  int64_t nr_running = ready_thread_cnt + 1;
+  int64_t period = CFS_LATENCY_NS;
+  int64_t weight = cfs_weight (t);
+
+  if (nr_running * CFS_MIN_GRAN_NS > period)
+    period = nr_running * CFS_MIN_GRAN_NS;
+  return period * weight / (cfs_load + weight);
+}
+
+/* cfs에서 실행 중인 스레드 CUR가 cfs_queue의 top에게 CPU를 양보해야
+   하면 true를 반환한다. */
+static bool
+cfs_should_preempt (struct thread *cur)
+{
+  enum intr_level old_level;
+  bool preempt = false;
+
+  old_level = intr_disable ();
+  if (!heap_empty (&cfs_queue))
+    {
+      struct thread *top = heap_entry (heap_top (&cfs_queue), struct thread,
+                                       cfs_elem);
+      if (cur == idle_thread)
+        preempt = true;
+      else
+        {
+          cfs_update_curr (cur);
+          preempt = cur->vruntime - top->vruntime > CFS_WAKEUP_GRAN_NS;
+        }
+    }
+  intr_set_level (old_level);
+  return preempt;
+}
+
+/* edf_queue에서 deadline이 더 이른 thread가 앞에 오도록 비교하는 함수이다. */
+static bool
+cmp_deadline (const struct heap_elem *a, const struct heap_elem *b,
+              void *aux UNUSED)
+{
+  struct thread *thread_a = heap_entry (a, struct thread, edf_elem);
+  struct thread *thread_b = heap_entry (b, struct thread, edf_elem);
+
+  return thread_a->edf_deadline < thread_b->edf_deadline;
+}
+
+/* PERIOD마다 BUDGET만큼 실행하는 스레드의 CPU 사용률을 1/1000 단위로
+   반환한다. admission control이 보수적이도록 올림한다. */
+static int
+edf_utilization (int64_t period, int64_t budget)
+{
+  return (budget * 1000 + period - 1) / period;
+}
+
+/* EDF 스레드 T의 다음 job을 준비한다. 다음 job은 현재 deadline에
+   release되지만, NOW가 이미 그 뒤라면 지나간 주기들은 건너뛰고 NOW가
+   속한 주기에 바로 release된다. deadline과 budget을 새 주기에 맞게
+   다시 채우고 release 시각을 반환한다. */
+static int64_t
+edf_next_job (struct thread *t, int64_t now)
+{
+  int64_t release = t->edf_deadline;
+
+  if (release < now)
+    release += (now - release) / t->edf_period * t->edf_period;
+  t->edf_deadline = release + t->edf_period;
+  t->edf_runtime = t->edf_budget;
+  return release;
+}
+
+/* 이번 주기의 budget을 다 쓴 EDF 스레드 T를 다음 주기가 시작될 때까지
+   sleep_heap에 넣는다. 현재 job은 deadline 전에 다시 실행될 수 없으므로
+   deadline miss로 센다. 다음 주기가 이미 시작되었다면 바로 ready queue에
+   넣는다. thread_yield()에서 interrupt가 꺼진 상태로 호출된다. */
+static void
+edf_throttle (struct thread *t)
+{
+  int64_t now = timer_ticks ();
+  int64_t release;
+
+  t->edf_throttled = false;
+  t->edf_overruns++;
+  t->edf_misses++;
+  release = edf_next_job (t, now);
+  if (release > now)
+    {
+      t->wakeup_tick = release;
+      heap_push (&sleep_heap, &t->sleep_elem);
+      update_next_tick_to_awake (release);
+      t->block_kind = BLOCK_SLEEP;
+      trace_event (TRACE_BLOCK, t->tid, t->block_kind, 0);
+      t->status = THREAD_BLOCKED;
+    }
+  else
+    {
+      ready_queue_push (t);
+      t->status = THREAD_READY;
+    }
+}
+
+/* 실행 중인 스레드 CUR가 edf_queue의 top에게 CPU를 양보해야 하면 true를
+   반환한다. EDF가 아닌 스레드는 ready 상태인 EDF 스레드가 있으면 항상
+   양보한다. */
+static bool
+edf_should_preempt (struct thread *cur)
+{
+  enum intr_level old_level;
+  bool preempt = false;
+
+  old_level = intr_disable ();
+  if (!heap_empty (&edf_queue))
+    {
+      struct thread *top = heap_entry (heap_top (&edf_queue), struct thread,
+                                       edf_elem);
+      preempt = cur->edf_period == 0 || top->edf_deadline < cur->edf_deadline;
+    }
+  intr_set_level (old_level);
+  return preempt;
+}
+
+/* mlfqs에서 스레드 T의 우선순위를 recent_cpu와 nice 값으로 다시 계산한다.
+   priority = PRI_MAX - (recent_cpu / 4) - (nice * 2) */
+static void
+mlfqs_priority (struct thread *t)
+{
+  int priority;
+
+  if (t == idle_thread)
+    return;
+
+  priority = fp_to_int (add_mixed (div_mixed (t->recent_cpu, -4),
+                                   PRI_MAX - t->nice * 2));
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+  thread_change_priority (t, priority);
+}
+
+/* mlfqs에서 스레드 T의 recent_cpu를 감쇠시킨다.
+   recent_cpu = (2 * load_avg) / (2 * load_avg + 1) * recent_cpu + nice */
+static void
+mlfqs_recent_cpu (struct thread *t)
+{
+  int load2;
+
+  if (t == idle_thread)
+    return;
+
+  load2 = mult_mixed (load_avg, 2);
+  t->recent_cpu = add_mixed (mult_fp (div_fp (load2, add_mixed (load2, 1)),
+                                      t->recent_cpu),
+                             t->nice);
+}
+
+/* 시스템 평균 부하를 갱신한다.
+   load_avg = (59 / 60) * load_avg + (1 / 60) * ready_threads
+   READY_THREADS는 실행 중이거나 ready 상태인 스레드 수(idle 제외)이다. */
+static void
+mlfqs_load_avg (int ready_threads)
+{
+  load_avg = add_fp (mult_fp (div_fp (int_to_fp (59), int_to_fp (60)), load_avg),
+                     mult_mixed (div_fp (int_to_fp (1), int_to_fp (60)),
+                                 ready_threads));
+  if (load_avg < 0)
+    load_avg = 0;
+}
+
+/* 현재 실행 중인 스레드의 recent_cpu를 1 증가시킨다. 매 tick마다 호출되며,
+   다음 우선순위 재계산 때 다시 계산되도록 dirty 리스트에 넣어둔다. */
+static void
+mlfqs_increment (void)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur == idle_thread)
+    return;
+
+  cur->recent_cpu = add_mixed (cur->recent_cpu, 1);
+  if (!cur->mlfqs_dirty)
+    {
+      cur->mlfqs_dirty = true;
+      list_push_back (&mlfqs_dirty_list, &cur->dirty_elem);
+    }
+}
+
+/* 모든 스레드의 recent_cpu와 우선순위를 한 번에 다시 계산한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+mlfqs_recalc (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  mlfqs_recalc_batch (++mlfqs_epoch, INT32_MAX);
+}
+
+/* 이번 재계산(EPOCH)에서 아직 계산하지 않은 스레드를 최대 MAX개까지
+   recent_cpu와 우선순위를 다시 계산하고, 계산한 스레드 수를 반환한다.
+   계산한 스레드는 dirty 리스트에서 빼고 all_list의 맨 뒤로 옮긴다.
+   새로 만들어진 스레드도 맨 뒤에 들어가므로 EPOCH로 표시된 스레드는
+   항상 all_list의 뒤쪽에 모여있고, 맨 앞만 보면 다음에 계산할 스레드를
+   찾을 수 있다. 따라서 한 번 호출하는 비용은 MAX개에 비례한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static int
+mlfqs_recalc_batch (unsigned epoch, int max)
+{
+  int cnt = 0;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (cnt < max && !list_empty (&all_list))
+    {
+      struct thread *t = list_entry (list_front (&all_list),
+                                     struct thread, allelem);
+      if (t->mlfqs_epoch == epoch)
+        break;
+      t->mlfqs_epoch = epoch;
+      mlfqs_recent_cpu (t);
+      mlfqs_priority (t);
+      if (t->mlfqs_dirty)
+        {
+          list_remove (&t->dirty_elem);
+          t->mlfqs_dirty = false;
+        }
+      list_remove (&t->allelem);
+      list_push_back (&all_list, &t->allelem);
+      cnt++;
+    }
+  return cnt;
+}
+
+/* system_wq에서 실행되는 1초마다의 재계산.
+   MLFQS_BATCH개씩 계산하고 그 사이에 interrupt를 켜서, interrupt가
+   꺼져있는 시간이 스레드 수에 비례해서 길어지지 않게 한다. 각 batch는
+   all_list의 앞에서부터 MLFQS_BATCH개만 보므로 전체 재계산은 스레드
+   수에 비례한다. 재계산 중에 만들어진 스레드는 이번 epoch로 표시되어
+   all_list의 맨 뒤에 들어가므로 이번 재계산에서는 건너뛴다. */
+static void
+mlfqs_recalc_work (void *aux UNUSED)
+{
+  enum intr_level old_level;
+  unsigned epoch;
+  int cnt;
+
+  old_level = intr_disable ();
+  epoch = ++mlfqs_epoch;
+  intr_set_level (old_level);
+
+  do
+    {
+      old_level = intr_disable ();
+      cnt = mlfqs_recalc_batch (epoch, MLFQS_BATCH);
+      intr_set_level (old_level);
+    }
+  while (cnt > 0);
+
+  /* 우선순위가 바뀌어 더 높은 우선순위의 스레드가 생겼다면 양보한다. */
+  old_level = intr_disable ();
+  test_max_priority ();
+  intr_set_level (old_level);
+}
+
+/* 4 tick마다 recent_cpu가 바뀐 스레드들만 우선순위를 다시 계산한다.
+   다른 스레드들은 recent_cpu, nice가 그대로이므로 우선순위도 그대로이다. */
+static void
+mlfqs_recalc_dirty (void)
+{
+  while (!list_empty (&mlfqs_dirty_list))
+    {
+      struct list_elem *e = list_pop_front (&mlfqs_dirty_list);
+      struct thread *t = list_entry (e, struct thread, dirty_elem);
+      t->mlfqs_dirty = false;
+      mlfqs_priority (t);
+    }
+}
+
  /* 자신이 가지고 있는 priority를 자신이 acquire하려고 하는 lock을 갖고있는 thread에게 donate하고, 
     nested되어 있는 경우 최대 8개 depth 까지 donation이 이뤄진다.
-    lock_acquire(), thread_set_priority() 에 의해 호출되어진다.*/
+    lock_acquire(), rwlock_acquire_*(), thread_set_priority() 에 의해 호출되어진다.
+    각 lock은 기다리는 thread들을 우선순위 wait queue로, 각 thread는
+    점유한 lock들(held_locks)을 lock의 최대 대기 우선순위 max heap으로 관리하므로
+    한 단계마다 O(log n)에 donation이 반영된다. */
 void donate_priority (void) {
-  int depth = 1;
-  struct thread *thread = thread_current (); 
-  struct lock *lock = thread->wait_on_lock;
-  while (depth < MAX_DEPTH && lock) {
-    /* 해당 스레드가 기다리고 있는 락이 있을경우, 현재 스레드의 우선순위보다
-       현재 스레드가 기다리고 있는 락을 점유한 스레드의 우선순위가 작을 때, 
-       락을 점유하고 있는 스레드의 우선순위가 높아질 수 있도록 
-       현재 스레드의 우선순위를 donation한다.*/
-    if (   lock->holder 
-        && lock->holder->priority < thread->priority ) { 
-      lock->holder->priority = thread->priority;
-      thread = lock->holder;
-      lock = thread->wait_on_lock;
-      depth++;
-    } else {
-      /* 위 조건문을 실행해지 못했다는 것은, nested된 thread가 더이상 없다거나,
-         있더라도 자신보다 우선순위가 더 높은 경우이므로
-         nested priority donation을 수행하는 반복문을 탈출한다. */
-      break;
-    }
+  donate_to_holders (thread_current (), 0);
+}
+
+/* thread T가 기다리고 있는 wait queue의 대상을 점유한 thread들에게 donate한다.
+   rwlock을 읽기로 점유한 thread들처럼 점유한 thread가 여럿이면 모두에게 donate하고,
+   점유한 thread도 다른 lock을 기다리고 있다면 DEPTH를 늘려가며 전파한다. */
+static void
+donate_to_holders (struct thread *t, int depth)
+{
+  struct list_elem *e;
+
+  /* thread의 wait queue 안의 위치는 thread_change_priority()가 이미 갱신했다.
+     lock이 막 해제되어 아직 다음 holder가 정해지지 않았다면 holds가 비어있고,
+     다음 holder가 lock을 얻을 때 wait queue에서 우선순위를 가져간다. */
+  if (depth >= MAX_DEPTH || t->wait_queue == NULL)
+    return;
+
+  for (e = list_begin (&t->wait_queue->holds);
+       e != list_end (&t->wait_queue->holds); e = list_next (e)) {
+    struct lock_hold *hold = list_entry (e, struct lock_hold, list_elem);
+    struct thread *holder = hold->holder;
+    int old_priority = holder->priority;
+
+    /* lock의 최대 대기 우선순위가 바뀌었으므로 holder의 held_locks heap을
+       갱신하고 holder의 우선순위를 다시 계산한다. */
+    heap_update (&holder->held_locks, &hold->elem);
+    thread_refresh_priority (holder);
+
+    /* holder의 우선순위가 그대로라면 더 이상 전파할 필요가 없다. */
+    if (holder->priority != old_priority)
+      donate_to_holders (holder, depth + 1);
   }
 }
 
-/* 락을 해제하기 전에 해당 lock을 기다리기 위해
-   우선순위를 현재 스레드에게 donate한 스레드들의 donation_elem을
-   현재 스레드의 donations list에서 빼준다.
-   이는 donated priority가 락을 해제함으로서 반납되는 것을 의미한다. */
-void remove_with_lock (struct lock *lock) {
-  struct thread *donatee = thread_current (); 
-  struct list_elem *cur_elem = list_begin (&donatee->donations);
-  struct thread *donator = NULL;
-
- /*   for (elem = list_begin (lock_waiters)
-      ; elem != list_end (lock_waiters); elem = list_next (elem)) {
-    donator = list_entry (elem, struct thread, elem);
-    list_remove (&donator->donation_elem);
-  }  */
-  while (cur_elem != list_end (&donatee->donations)) {
-    donator = list_entry (cur_elem, struct thread, donation_elem);
-    cur_elem = list_next (cur_elem); 
-    if (donator->wait_on_lock == lock) {
-      list_remove (&donator->donation_elem);
-    }
+/* thread T의 우선순위를 init_priority와 T가 점유한 lock들을 기다리는 thread들이
+   donate해준 priority 중 가장 높은 값으로 바꾼다.
+   held_locks heap의 top이 가장 높은 donated priority를 가진 lock이므로 O(1)에 찾는다. */
+void
+thread_refresh_priority (struct thread *t)
+{
+  int max_priority = t->init_priority;
+
+  /* init_priority에는 초기에 설정된 priority가 저장되어 있어서
+     donated priority를 반납받고 원래 priority로 돌아갈 수 있다.*/
+  if (!heap_empty (&t->held_locks)) {
+    struct lock_hold *hold = heap_entry (heap_top (&t->held_locks),
+                                         struct lock_hold, elem);
+    int donated = wait_queue_priority (hold->waiters);
+    if (max_priority < donated)
+      max_priority = donated;
   }
-} 
-/* void remove_with_lock(struct lock *lock)
-{
-  struct list_elem *e = list_begin(&thread_current()->donations);
-  struct list_elem *next;
-  while (e != list_end(&thread_current()->donations))
-    {
-      struct thread *t = list_entry(e, struct thread, donation_elem);
-      next = list_next(e);
-      if (t->wait_on_lock == lock)
-	{
-	  list_remove(e);
-	}
-      e = next;
-    }
-} */
+  thread_change_priority (t, max_priority);
+}
+
 /*어떤 스레드가 우선순위가 새로 바뀌거나, lock을 반환하고 donated priority를 반납하면서
   우선순위가 변경될 때, 변경된 우선순위와 다른 lock을 점유하면서 다른 스레드들이 해당 lock을
   대기하면서 donate해준  priority들과 비교하여 가장 높은 priority로 바꾸는 작업을 함.  */
 void refresh_priority (void) {
-  struct thread *cur = thread_current (); 
-  struct thread *donator = NULL;
-  struct list_elem *elem = NULL;
-  int max_priority = cur->init_priority;
-  
-
-  /*자신의 priority는 바뀌었지만 비교할 donated priority가 없다면,
-    새로 바뀐 priority를 적용하고 return 한다. 
-    init_priority에는 초기에 설정된 priority가 저장되어 있어서
-    donated priority를 받납받고 원래 priority로 돌아갈 수 있다.*/
-  if (list_empty (&cur->donations)) {
-    cur->priority = cur->init_priority;
-    return;
-  }
-  /* 이 루틴은 donated priority가 있는 경우에만 진입 가능함.
-     donated priority가 있는 경우, 새로 변경된 priority와
-     donated priority들을 비교하여 최대값을 취함.
-     사실 donations list는 우선순위에 따라 내림차순으로 정렬되어 있어
-     리스트 head가 가리키고 있는 element가 가장 큰 값이다. */
-  elem = list_begin (&cur->donations);  
-  donator = list_entry (elem, struct thread, donation_elem);
-  if (max_priority < donator->priority) {
-    max_priority = donator->priority;
-  }
-  cur->priority = max_priority;
+  thread_refresh_priority (thread_current ());
 }
 
 /* Initializes the threading system by transforming the code
@@ -210,11 +824,28 @@ thread_init (void)
 {
   ASSERT (intr_get_level () == INTR_OFF);
 
+  int i;
+
   lock_init (&tid_lock);
-  list_init (&ready_list);
+  for (i = 0; i < READY_QUEUE_CNT; i++)
+    list_init (&ready_queue[i]);
+  ready_bitmap = 0;
+  ready_thread_cnt = 0;
+  heap_init (&cfs_queue, cmp_vruntime, NULL);
+  heap_init (&edf_queue, cmp_deadline, NULL);
+  edf_util = 0;
+  cfs_load = 0;
+  cfs_min_vruntime = 0;
+  list_init (&mlfqs_dirty_list);
+  load_avg = 0;
+  work_init (&mlfqs_work, mlfqs_recalc_work, NULL);
+  mlfqs_epoch = 0;
   list_init (&all_list);
-  /* sleep_list 초기화 함. */
-  list_init (&sleep_list);
+  list_init (&page_cache);
+  page_cache_cnt = 0;
+  list_init (&reap_list);
+  /* sleep_heap 초기화 함. */
+  heap_init (&sleep_heap, cmp_wakeup_tick, NULL);
 
 
   /* Set up a thread structure for the running thread. */
@@ -234,6 +865,10 @@ thread_start (void)
   sema_init (&idle_started, 0);
   thread_create ("idle", PRI_MIN, idle, &idle_started);
 
+  /* interrupt handler에서 미룬 일들을 실행할 worker 스레드를 만든다. */
+  if (!workqueue_create (&system_wq, "kworker", PRI_MAX, 1))
+    PANIC ("cannot start kernel worker thread");
+
   /* Start preemptive thread scheduling. */
   intr_enable ();
 
@@ -249,6 +884,7 @@ thread_tick (void)
   struct thread *t = thread_current ();
 
   /* Update statistics. */
+  t->run_ticks++;
   if (t == idle_thread)
     idle_ticks++;
 #ifdef USERPROG
@@ -258,9 +894,84 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  /* mlfqs에서는 매 tick마다 실행 중인 스레드의 recent_cpu만 증가시키고,
+     1초마다 load_avg와 모든 스레드의 recent_cpu를, 4 tick마다
+     recent_cpu가 바뀐 스레드들의 우선순위를 다시 계산한다.
+     모든 스레드의 재계산은 system_wq의 worker 스레드에게 넘긴다.
+     worker는 PRI_MAX이므로 이 interrupt가 끝나자마자 실행된다. */
+  if (thread_mlfqs)
+    {
+      int64_t now = timer_ticks ();
+
+      mlfqs_increment ();
+      if (now % TIMER_FREQ == 0)
+        {
+          /* ready_threads는 ready queue에서 같이 세고 있으므로
+             리스트를 순회하지 않는다. */
+          mlfqs_load_avg (ready_thread_cnt + (t != idle_thread ? 1 : 0));
+          work_queue (&system_wq, &mlfqs_work);
+        }
+      else if (now % 4 == 0)
+        mlfqs_recalc_dirty ();
+
+      /* 우선순위가 바뀌어 더 높은 우선순위의 스레드가 생겼다면 양보한다. */
+      test_max_priority ();
+    }
+
+  /* EDF 스레드는 실행한 만큼 budget을 쓰고, 다 쓰면 다음 주기까지
+     멈춘다. 다른 스케줄링 클래스의 time slice는 적용하지 않는다. */
+  if (t->edf_period != 0)
+    {
+      if (--t->edf_runtime <= 0)
+        {
+          t->edf_throttled = true;
+          t->preempted = true;
+          intr_yield_on_return ();
+        }
+      return;
+    }
+
+  /* cfs에서는 고정된 TIME_SLICE 대신 가중치에 따라 정해지는 slice를
+     다 쓰면 양보한다. */
+  if (thread_cfs)
+    {
+      cfs_update_curr (t);
+      if (!heap_empty (&cfs_queue)
+          && (t == idle_thread || t->slice_exec >= cfs_slice (t)))
+        {
+          t->preempted = true;
+          intr_yield_on_return ();
+        }
+      return;
+    }
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
-    intr_yield_on_return ();
+    {
+      t->preempted = true;
+      intr_yield_on_return ();
+    }
+}
+
+/* tickless idle 동안 timer interrupt 없이 지나간 tick들 (FROM, TO]을
+   통계와 mlfqs 계산에 반영한다. 그 동안에는 idle thread만 실행 중이었으므로
+   ready_threads는 0이다. interrupt가 꺼진 상태에서 호출되어야 한다. */
+void
+thread_tick_idle (int64_t from, int64_t to)
+{
+  int64_t t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (t = from + 1; t <= to; t++)
+    {
+      idle_ticks++;
+      if (thread_mlfqs && t % TIMER_FREQ == 0)
+        {
+          mlfqs_load_avg (0);
+          mlfqs_recalc ();
+        }
+    }
 }
 
 /* thread를 block상태로 만들고 원하는 timer ticks에 timer_interrupt에 의해
@@ -269,53 +980,70 @@ thread_tick (void)
    timer tick 1번은 0.01초이다. (timer.h의 TIMER_FREQ 100 기준) */
 void thread_sleep (int64_t ticks) {
   struct thread *cur = thread_current ();
-  /* list 삽입이 일어나는 동안 race condition이 발생하지 않도록
+  /* heap 삽입이 일어나는 동안 race condition이 발생하지 않도록
      interrupt를 disable해준다. */
   enum intr_level old_level = intr_disable ();
   /* idle thread는 block상태가 되지않게 예외처리를 해준다.
+     이미 깨어날 시간이 지났다면 block하지 않고 바로 돌아간다.
      그 이외의 thread들에 대해서는 sleep을 수행하기 위해 block시킨다.*/
-  if (cur != idle_thread)  {
-    /* sleep_list에 깨워야할 ticks 정보를 담은 thread 구조체의 elem을 삽입하여
-       sleep list를 관리한다. 해당 리스트는 삽입시 정렬하지 않으며,
-       thread를 깨우기 위해 thread_awake() 에 의해 전체 순회가 된다. */
+  if (cur != idle_thread && ticks > timer_ticks ())  {
+    /* sleep_heap에 깨워야할 ticks 정보를 담은 thread 구조체의 sleep_elem을 삽입한다.
+       heap은 wakeup_tick이 가장 작은 thread를 top에 유지하므로,
+       thread_awake()는 깨울 thread들만 꺼내면 된다. */
     cur->wakeup_tick = ticks; 
-    list_push_back (&sleep_list, &cur->elem);
+    heap_push (&sleep_heap, &cur->sleep_elem);
     /* timer interrupt가 매번 thread_awake()를 호출하는 것이 아닌,
        깨워야할 thread가 있을 때만 호출할 수 있도록 next_tick_to_awake 라는 전역변수를
-       sleep_list에서의 가장 작은 ticks를 가진 thread의 ticks값으로 바꿔준다. */
+       sleep_heap에서의 가장 작은 ticks를 가진 thread의 ticks값으로 바꿔준다. */
     update_next_tick_to_awake (ticks); 
+    cur->block_kind = BLOCK_SLEEP;
     thread_block ();
   
   }
   intr_set_level (old_level);
 }
 
-/*이 함수는 sleep_list에서 깨울 thread가 있을 때만 호출된다.
-  sleep_list를 순회하면서 깨울 thread는 ready상태로 만들어주고,
-  아직 깨울 때가 아닌 thread는 다른 스레드가 깨워지면서 바뀌어야할 
-  next_tick_to_awake 값을 갱신한다. */
+/* sleep_heap에서 wakeup_tick이 더 작은 thread가 앞에 오도록 비교하는 함수이다. */
+static bool
+cmp_wakeup_tick (const struct heap_elem *a, const struct heap_elem *b,
+                 void *aux UNUSED)
+{
+  struct thread *thread_a = heap_entry (a, struct thread, sleep_elem);
+  struct thread *thread_b = heap_entry (b, struct thread, sleep_elem);
+
+  return thread_a->wakeup_tick < thread_b->wakeup_tick;
+}
+
+/*이 함수는 sleep_heap에서 깨울 thread가 있을 때만 호출된다.
+  sleep_heap의 top에서부터 깨울 시간이 된 thread들만 꺼내서 ready상태로 만들어주고,
+  남은 thread 중 가장 작은 wakeup_tick으로 next_tick_to_awake 값을 갱신한다.
+  깨우는 thread 수를 k라 할 때 O(k log n)이다. */
 void thread_awake (int64_t ticks) {
-  struct list_elem *elem = list_begin (&sleep_list);
-  struct list_elem *cur_elem = NULL;
   struct thread *pcb = NULL;
-  /* next_tick_to_awake 값이 새로 갱신될 수 있도록 충분히 큰 값으로 초기화 한다.
-     INT64_MAX 는 비교시 버그가 있어서 더 작은값으로 대체하였다.
-     set_next_tick_to_awake() 함수가 필요할 것 같지만, 당장은 이렇게 구현하였다.*/
-  next_tick_to_awake = INT32_MAX;
-    /* sleep_list를 처음부터 끝까지 순회한다. */
-  while (elem != list_end (&sleep_list)) {
-    pcb = list_entry (elem, struct thread, elem);
-    cur_elem = elem; 
-    elem = list_next (elem);
-    /* 현재 ticks보다 해당 pcb의 ticks가 작으면 해당 스레드를 깨운다. */
-    if (pcb->wakeup_tick <= ticks) {
-      list_remove (cur_elem);
-      thread_unblock (pcb);
-    } else {
-      /* 현재 ticks 보다 큰경우 next_tick_to_awake 를 갱신한다. */
-      update_next_tick_to_awake (pcb->wakeup_tick);
-    }
+  bool woken = false;
+
+  while (!heap_empty (&sleep_heap)) {
+    pcb = heap_entry (heap_top (&sleep_heap), struct thread, sleep_elem);
+    /* top의 wakeup_tick이 현재 ticks보다 크면 더 깨울 thread가 없다. */
+    if (pcb->wakeup_tick > ticks)
+      break;
+    heap_pop (&sleep_heap);
+    thread_unblock (pcb);
+    woken = true;
   }
+  /* 깨어난 스레드가 실행 중인 스레드보다 먼저 실행되어야 한다면
+     interrupt가 끝날 때 양보한다. 주기가 시작된 EDF 스레드가 바로
+     실행되려면 필요하다. */
+  if (woken)
+    test_max_priority ();
+
+  /* next_tick_to_awake 값을 heap의 top으로 갱신한다.
+     INT64_MAX 는 비교시 버그가 있어서 더 작은값으로 대체하였다. */
+  if (heap_empty (&sleep_heap))
+    next_tick_to_awake = INT32_MAX;
+  else
+    next_tick_to_awake = heap_entry (heap_top (&sleep_heap), struct thread,
+                                     sleep_elem)->wakeup_tick;
 }
 /* next_tick_to_awake 값을 갱신해주는 함수이다. */
 void update_next_tick_to_awake (int64_t ticks) {
@@ -337,6 +1065,187 @@ thread_print_stats (void)
           idle_ticks, kernel_ticks, user_ticks);
 }
 
+/* 스레드 이름별 커널 스택 최대 사용량을 출력한다.
+   종료된 스레드들의 기록에 아직 살아 있는 스레드들의 사용량을 더한다. */
+void
+thread_print_stack_stats (void)
+{
+  static struct stack_stat stats[STACK_STAT_CNT];
+  enum intr_level old_level;
+  struct list_elem *e;
+  int cnt, i;
+
+  old_level = intr_disable ();
+  memcpy (stats, stack_stats, sizeof stats);
+  cnt = stack_stat_cnt;
+  for (e = list_begin (&all_list); e != list_end (&all_list);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      if (t != initial_thread)
+        stack_stat_add (stats, &cnt, t);
+    }
+  intr_set_level (old_level);
+
+  printf ("Kernel stack: struct thread is %zu bytes, "
+          "%zu bytes left for the stack\n",
+          sizeof (struct thread), PGSIZE - sizeof (struct thread));
+  printf ("  NAME             THREADS MAX-USED MIN-FREE\n");
+  for (i = 0; i < cnt; i++)
+    printf ("  %-16s %7u %8zu %8zu\n", stats[i].name, stats[i].threads,
+            stats[i].max_used,
+            PGSIZE - sizeof (struct thread) - stats[i].max_used);
+}
+
+/* 새 스레드 T의 page에서 struct thread 위의 스택 영역 전체를
+   STACK_CANARY로 채운다. */
+static void
+stack_fill (struct thread *t)
+{
+  uint32_t *p = (uint32_t *) (t + 1);
+  uint32_t *top = (uint32_t *) ((uint8_t *) t + PGSIZE);
+
+  while (p < top)
+    *p++ = STACK_CANARY;
+}
+
+/* 스레드 T가 지금까지 가장 깊이 사용한 커널 스택의 크기를 반환한다.
+   STACK_CANARY가 남아 있는 부분은 사용하지 않은 것으로 본다. */
+static size_t
+stack_used (const struct thread *t)
+{
+  const uint32_t *p = (const uint32_t *) (t + 1);
+  const uint8_t *top = (const uint8_t *) t + PGSIZE;
+
+  while ((const uint8_t *) p < top && *p == STACK_CANARY)
+    p++;
+  return top - (const uint8_t *) p;
+}
+
+/* 스레드 T의 스택 사용량을 CNT개의 기록이 있는 STATS에 더한다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+stack_stat_add (struct stack_stat *stats, int *cnt, const struct thread *t)
+{
+  size_t used = stack_used (t);
+  struct stack_stat *s;
+  int i;
+
+  for (i = 0; i < *cnt; i++)
+    if (!strcmp (stats[i].name, t->name))
+      break;
+  if (i == *cnt)
+    {
+      if (*cnt < STACK_STAT_CNT)
+        {
+          (*cnt)++;
+          strlcpy (stats[i].name, t->name, sizeof stats[i].name);
+        }
+      else
+        {
+          i = STACK_STAT_CNT - 1;
+          strlcpy (stats[i].name, "(other)", sizeof stats[i].name);
+        }
+    }
+
+  s = &stats[i];
+  s->threads++;
+  if (used > s->max_used)
+    s->max_used = used;
+}
+
+/* 상태가 바뀌기 직전의 thread T에 대해, 현재 상태로 있었던 시간을
+   스케줄러 통계에 더한다. RUNNING 상태였던 시간은 thread_tick()에서 센다.
+   interrupt가 꺼진 상태에서 호출되어야 한다. */
+static void
+thread_stat_update (struct thread *t)
+{
+  int64_t now = timer_ticks ();
+  int64_t elapsed = now - t->stat_since;
+
+  if (t->status == THREAD_READY)
+    {
+      t->ready_ticks += elapsed;
+      if (elapsed > t->max_ready_ticks)
+        t->max_ready_ticks = elapsed;
+    }
+  else if (t->status == THREAD_BLOCKED)
+    {
+      if (t->block_kind == BLOCK_SYNC)
+        t->sync_ticks += elapsed;
+      else if (t->block_kind == BLOCK_SLEEP)
+        t->sleep_ticks += elapsed;
+      else
+        t->other_ticks += elapsed;
+    }
+  t->stat_since = now;
+}
+
+/* 살아있는 스레드들의 스케줄러 통계를 최대 CNT개까지 STATS에 채우고
+   채운 개수를 반환한다. 현재 상태로 있었던 시간도 포함한다. */
+int
+thread_get_stats (struct thread_stat *stats, int cnt)
+{
+  enum intr_level old_level = intr_disable ();
+  int64_t now = timer_ticks ();
+  struct list_elem *e;
+  int n = 0;
+
+  for (e = list_begin (&all_list); e != list_end (&all_list) && n < cnt;
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      struct thread_stat *s = &stats[n++];
+      int64_t elapsed = now - t->stat_since;
+
+      s->tid = t->tid;
+      strlcpy (s->name, t->name, sizeof s->name);
+      s->status = t->status;
+      s->priority = t->priority;
+      s->nice = t->nice;
+      s->run_ticks = t->run_ticks;
+      s->ready_ticks = t->ready_ticks;
+      s->max_ready_ticks = t->max_ready_ticks;
+      s->sync_ticks = t->sync_ticks;
+      s->sleep_ticks = t->sleep_ticks;
+      s->other_ticks = t->other_ticks;
+      s->voluntary_switches = t->voluntary_switches;
+      s->involuntary_switches = t->involuntary_switches;
+      s->edf_period = t->edf_period;
+      if (t->edf_period != 0)
+        {
+          s->edf_budget = t->edf_budget;
+          s->edf_jobs = t->edf_jobs;
+          s->edf_misses = t->edf_misses;
+          s->edf_overruns = t->edf_overruns;
+        }
+      else
+        {
+          s->edf_budget = 0;
+          s->edf_jobs = s->edf_misses = s->edf_overruns = 0;
+        }
+
+      if (t->status == THREAD_READY)
+        {
+          s->ready_ticks += elapsed;
+          if (elapsed > s->max_ready_ticks)
+            s->max_ready_ticks = elapsed;
+        }
+      else if (t->status == THREAD_BLOCKED)
+        {
+          if (t->block_kind == BLOCK_SYNC)
+            s->sync_ticks += elapsed;
+          else if (t->block_kind == BLOCK_SLEEP)
+            s->sleep_ticks += elapsed;
+          else
+            s->other_ticks += elapsed;
+        }
+    }
+  intr_set_level (old_level);
+
+  return n;
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -355,6 +1264,78 @@ thread_print_stats (void)
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
+{
+  return do_thread_create (name, priority, 0, 0, function, aux);
+}
+
+/* PERIOD tick마다 BUDGET tick씩 실행하는 EDF 스레드를 만든다.
+   FUNCTION은 job 하나를 끝낼 때마다 thread_wait_period()를 호출해야 한다.
+   첫 주기는 지금 시작하며, 각 job의 deadline은 그 주기의 끝이다.
+
+   EDF 스레드는 다른 모든 스레드보다 먼저 실행되며, 주기마다 BUDGET보다
+   오래 실행하면 다음 주기까지 멈춘다. 이미 받아들인 EDF 스레드들과
+   합한 CPU 사용률이 EDF_UTIL_MAX를 넘으면 만들지 않고 TID_ERROR를
+   반환한다. EDF 스레드가 기다리는 lock의 holder가 donation으로 가장 높은
+   우선순위를 받도록 PRI_MAX로 만든다. */
+tid_t
+thread_create_periodic (const char *name, int64_t period, int64_t budget,
+                        thread_func *function, void *aux)
+{
+  enum intr_level old_level;
+  int util;
+  bool admit;
+  tid_t tid;
+
+  if (period <= 0 || budget <= 0 || budget > period)
+    return TID_ERROR;
+
+  /* Admission control. */
+  util = edf_utilization (period, budget);
+  old_level = intr_disable ();
+  admit = edf_util + util <= EDF_UTIL_MAX;
+  if (admit)
+    edf_util += util;
+  intr_set_level (old_level);
+  if (!admit)
+    return TID_ERROR;
+
+  tid = do_thread_create (name, PRI_MAX, period, budget, function, aux);
+  if (tid == TID_ERROR)
+    {
+      old_level = intr_disable ();
+      edf_util -= util;
+      intr_set_level (old_level);
+    }
+  return tid;
+}
+
+/* 실행 중인 EDF 스레드의 이번 job을 끝내고 다음 주기가 시작될 때까지
+   잠든다. deadline이 지난 뒤에 끝낸 job은 deadline miss로 센다. */
+void
+thread_wait_period (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int64_t now, release;
+
+  ASSERT (cur->edf_period != 0);
+
+  old_level = intr_disable ();
+  now = timer_ticks ();
+  cur->edf_jobs++;
+  if (now > cur->edf_deadline)
+    cur->edf_misses++;
+  release = edf_next_job (cur, now);
+  thread_sleep (release);
+  intr_set_level (old_level);
+}
+
+/* thread_create()와 thread_create_periodic()의 공통 부분.
+   PERIOD가 0이 아니면 EDF 스레드로 만든다. */
+static tid_t
+do_thread_create (const char *name, int priority,
+                  int64_t period, int64_t budget,
+                  thread_func *function, void *aux)
 {
   struct thread *t;
   struct kernel_thread_frame *kf;
@@ -362,24 +1343,59 @@ thread_create (const char *name, int priority,
   struct switch_threads_frame *sf;
   tid_t tid;
   enum intr_level old_level;
+#ifdef USERPROG
+  struct file **fdt;
+#endif
 
   ASSERT (function != NULL);
 
-  /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  /* Allocate thread.
+     init_thread()가 struct thread 부분을 0으로 채우므로
+     page 전체를 0으로 채울 필요는 없다. */
+  t = thread_page_alloc ();
   if (t == NULL)
     return TID_ERROR;
+#ifdef USERPROG
+  /* FDT는 반드시 0으로 초기화 해야하고 커널 풀에 할당해야함.
+     FILE_MAX개의 entry만 사용하므로 그 부분만 0으로 채운다. */
+  fdt = thread_page_alloc ();
+  if (fdt == NULL)
+    {
+      thread_page_free (t);
+      return TID_ERROR;
+    }
+  memset (fdt, 0, FILE_MAX * sizeof *fdt);
+#endif
 
   /* 새 스레드를 생성하고 초기화를 함.
      PCB에 새로 추가한 자식 프로세스 리스트 멤버를 여기 init_thread()에서 초기화함. */
   init_thread (t, name, priority);
   tid = t->tid = allocate_tid ();
 
+  /* mlfqs에서 자식 스레드는 부모의 nice와 recent_cpu를 물려받고,
+     인자로 받은 priority 대신 계산된 우선순위를 사용한다. */
+  t->nice = thread_current ()->nice;
+  t->recent_cpu = thread_current ()->recent_cpu;
+  if (thread_mlfqs)
+    mlfqs_priority (t);
+
   /* Prepare thread for first run by initializing its stack.
      Do this atomically so intermediate values for the 'stack' 
      member cannot be observed. */
   old_level = intr_disable ();
 
+  /* EDF 스레드의 첫 주기는 지금 시작하고, cfs에서 새 스레드는 현재의
+     cfs_min_vruntime에서 시작한다. */
+  if (period != 0)
+    {
+      t->edf_period = period;
+      t->edf_budget = budget;
+      t->edf_deadline = timer_ticks ();
+      edf_next_job (t, t->edf_deadline);
+    }
+  else
+    t->vruntime = cfs_min_vruntime;
+
   /* Stack frame for kernel_thread(). */
   kf = alloc_frame (t, sizeof *kf);
   kf->eip = NULL;
@@ -408,12 +1424,13 @@ thread_create (const char *name, int priority,
   sema_init(&t->load_sema, 0);
   sema_init(&t->exit_sema, 0);
 
-  /* file 관련 구조체들 초기화 함
-     FDT는 반드시 0으로 초기화 해야하고 커널 풀에 할당해야함 */
-  t->FDT = palloc_get_page (PAL_ZERO);
+#ifdef USERPROG
+  /* file 관련 구조체들 초기화 함 */
+  t->FDT = fdt;
   /* 0과 1은 이미 STDIN과 STDOUT이 사용중이므로 
      2번째 엔트리부터 파일 디스크립터를 할당 받을 수 있도록 2로 초기화 함 */
   t->next_fd = 2;
+#endif
 
   //커널에서 관리하는 모든 프로세스 리스트 구조체에 새로 생성된 PCB를 삽입함.
   list_push_back(&thread_current()->child_list, &t->child_elem);
@@ -434,13 +1451,108 @@ thread_create (const char *name, int priority,
 void
 thread_block (void) 
 {
+  struct thread *cur = thread_current ();
+
   ASSERT (!intr_context ());
   ASSERT (intr_get_level () == INTR_OFF);
 
-  thread_current ()->status = THREAD_BLOCKED;
+  /* wait queue에 들어가 있다면 동기화 객체를 기다리는 중이다. */
+  if (cur->block_kind == BLOCK_NONE)
+    cur->block_kind = cur->wait_queue != NULL ? BLOCK_SYNC : BLOCK_OTHER;
+  cfs_update_curr (cur);
+  thread_stat_update (cur);
+  trace_event (TRACE_BLOCK, cur->tid, cur->block_kind, 0);
+  cur->status = THREAD_BLOCKED;
   schedule ();
 }
 
+/* 부모가 자식 T의 PCB를 더 이상 참조하지 않을 때 호출한다.
+   T가 이미 종료되어 다른 스레드로 전환되었다면 T의 page를 바로 반환하고,
+   아니라면 T가 종료될 때 thread_schedule_tail()에서 반환되도록 표시한다. */
+void
+thread_release (struct thread *t)
+{
+  enum intr_level old_level;
+
+  ASSERT (is_thread (t));
+
+  old_level = intr_disable ();
+  if (t->status == THREAD_DYING)
+    thread_page_free (t);
+  else
+    t->released = true;
+  intr_set_level (old_level);
+}
+
+/* thread page나 FDT처럼 스레드가 사용할 page 하나를 할당한다.
+   먼저 page cache에서 꺼내고, 비어있으면 palloc에서 할당한다.
+   page의 내용은 초기화되어 있지 않다. 실패하면 NULL을 반환한다. */
+void *
+thread_page_alloc (void)
+{
+  enum intr_level old_level;
+  void *page = NULL;
+
+  thread_reap ();
+
+  old_level = intr_disable ();
+  if (!list_empty (&page_cache))
+    {
+      page = list_entry (list_pop_front (&page_cache), struct cached_page, elem);
+      page_cache_cnt--;
+    }
+  intr_set_level (old_level);
+
+  if (page == NULL)
+    page = palloc_get_page (0);
+  return page;
+}
+
+/* thread_page_alloc()으로 할당한 PAGE를 반환한다.
+   lock을 잡지 않으므로 interrupt가 꺼진 상태에서도 호출할 수 있다.
+   cache가 가득 찼다면 다음 thread_reap()에서 palloc에 돌려준다. */
+void
+thread_page_free (void *page)
+{
+  struct cached_page *p = page;
+  enum intr_level old_level;
+
+  if (page == NULL)
+    return;
+
+  old_level = intr_disable ();
+  if (page_cache_cnt < PAGE_CACHE_MAX)
+    {
+      list_push_front (&page_cache, &p->elem);
+      page_cache_cnt++;
+    }
+  else
+    list_push_back (&reap_list, &p->elem);
+  intr_set_level (old_level);
+}
+
+/* cache에 들어가지 못한 page들을 palloc에 돌려준다.
+   palloc의 lock을 잡을 수 있으므로 interrupt handler에서 호출하면 안 된다. */
+void
+thread_reap (void)
+{
+  ASSERT (!intr_context ());
+
+  for (;;)
+    {
+      enum intr_level old_level = intr_disable ();
+      struct cached_page *p = NULL;
+
+      if (!list_empty (&reap_list))
+        p = list_entry (list_pop_front (&reap_list), struct cached_page, elem);
+      intr_set_level (old_level);
+
+      if (p == NULL)
+        break;
+      palloc_free_page (p);
+    }
+}
+
 /* Transitions a blocked thread T to the ready-to-run state.
    This is an error if T is not blocked.  (Use thread_yield() to
    make the running thread ready.)
@@ -458,9 +1570,14 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  //list_push_back (&ready_list, &t->elem);
-  /* 우선순위를 고려한 스케줄링을 위해 우선순위에 따라 ready queue에 정렬하여 삽입한다. */
-  list_insert_ordered (&ready_list, &t->elem, cmp_priority, NULL);
+  if (thread_cfs && t->edf_period == 0)
+    cfs_place (t);
+  /* 우선순위를 고려한 스케줄링을 위해 우선순위별 ready queue에 삽입한다.
+     정렬 삽입이 아니므로 상수 시간에 끝난다. */
+  ready_queue_push (t);
+  thread_stat_update (t);
+  trace_event (TRACE_UNBLOCK, t->tid, running_thread ()->tid, 0);
+  t->block_kind = BLOCK_NONE;
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -468,15 +1585,43 @@ thread_unblock (struct thread *t)
 
 void test_max_priority (void) {
 
-  struct list_elem *cur = &thread_current ()->elem;
-  struct list_elem *highest_priority_thread;
+  struct thread *cur = thread_current ();
+
+  /* EDF 스레드는 다른 스케줄링 클래스보다 항상 먼저 실행되고,
+     EDF 스레드끼리는 deadline이 이른 스레드가 먼저 실행된다. */
+  if (edf_should_preempt (cur)) {
+    cur->preempted = true;
+    if (intr_context ())
+      intr_yield_on_return ();
+    else
+      thread_yield ();
+    return;
+  }
+  if (cur->edf_period != 0)
+    return;
+
+  /* cfs에서는 우선순위 대신 vruntime을 비교한다. */
+  if (thread_cfs) {
+    if (cfs_should_preempt (cur)) {
+      cur->preempted = true;
+      if (intr_context ())
+        intr_yield_on_return ();
+      else
+        thread_yield ();
+    }
+    return;
+  }
   
   /* ready queue에 제일 우선순위가 높은 thread와 현재 스레드의 우선순위를 비교해서
-     현재스레드가 우선순위가 낮으면 cpu를 양보한다.*/
-  if (!list_empty (&ready_list)) {
-    highest_priority_thread = list_begin (&ready_list);
-   
-    if (cmp_priority (highest_priority_thread, cur, NULL))
+     현재스레드가 우선순위가 낮으면 cpu를 양보한다.
+     bitmap만 확인하므로 ready queue의 길이와 상관없이 상수 시간이다.
+     interrupt handler 안에서 호출된 경우에는 바로 yield할 수 없으므로
+     handler가 끝날 때 yield하도록 한다. */
+  if (ready_queue_max_priority () > cur->priority) {
+    cur->preempted = true;
+    if (intr_context ())
+      intr_yield_on_return ();
+    else
       thread_yield ();
   }
   return;
@@ -529,6 +1674,7 @@ thread_exit (void)
 #ifdef USERPROG
   process_exit ();
 #endif
+  fpu_exit (thread_current ());
 
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
@@ -537,10 +1683,25 @@ thread_exit (void)
 
   // 커널에서 전체 프로세스 목록을 관리하는 리스트에서 종료하고자 하는 프로세스 PCB element를 제거함.
   list_remove (&thread_current()->allelem);
+  if (thread_current ()->mlfqs_dirty)
+    list_remove (&thread_current ()->dirty_elem);
+  /* EDF 스레드가 받아둔 CPU 사용률을 돌려준다. */
+  if (thread_current ()->edf_period != 0)
+    edf_util -= edf_utilization (thread_current ()->edf_period,
+                                 thread_current ()->edf_budget);
   
   // 현재 프로세스의 PCB에 종료된 프로세스임을 표시함.
   thread_current ()->exited = true;
 
+  /* 이 스레드가 사용한 커널 스택의 깊이를 기록한다. */
+  if (thread_current () != initial_thread)
+    stack_stat_add (stack_stats, &stack_stat_cnt, thread_current ());
+
+  /* 더 이상 기다려줄 부모가 없으므로 자식들의 PCB를 놓아준다. */
+  while (!list_empty (&thread_current ()->child_list))
+    thread_release (list_entry (list_pop_front (&thread_current ()->child_list),
+                                struct thread, child_elem));
+
   /* 커널이 부팅하고 나서 첫번째와 두번째로 생기는 main 프로세스와 idle프로세스는 
      PCB내부의 세마포어 객체를 사용하지 않고 커널에서 관리하는 전용 전역 semaphore객체를 사용하므로
      PCB 내부의 세마포어 객체를 다루는 이 루틴에서 main 프로세스와 idle프로세스에 대해선 작동하지 않게함.*/
@@ -565,11 +1726,20 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
-  /* if (cur != idle_thread) 
-    list_push_back (&ready_list, &cur->elem); */
-  /* 기존 fifo로 구현된 readylist에 정렬삽입으로 재구현한다. */
-  list_insert_ordered (&ready_list, &cur->elem, cmp_priority, NULL);  
-  cur->status = THREAD_READY;
+  /* cfs_queue에서의 위치가 정해지도록 지금까지 실행한 시간을 먼저 반영한다. */
+  cfs_update_curr (cur);
+  thread_stat_update (cur);
+  /* budget을 다 쓴 EDF 스레드는 다음 주기까지 잠든다. */
+  if (cur->edf_period != 0 && cur->edf_throttled)
+    edf_throttle (cur);
+  else
+    {
+      /* idle thread는 ready queue에 넣지 않는다. ready queue가 비어있을 때
+         next_thread_to_run()이 따로 반환해준다. */
+      if (cur != idle_thread) 
+        ready_queue_push (cur);
+      cur->status = THREAD_READY;
+    }
   schedule ();
   intr_set_level (old_level);
 }
@@ -597,6 +1767,10 @@ thread_set_priority (int new_priority)
 {
   struct thread *cur = thread_current ();
   int old_priority = cur->priority;
+
+  /* mlfqs에서는 스케줄러가 우선순위를 직접 관리하므로 무시한다. */
+  if (thread_mlfqs)
+    return;
   /*초기 priority값도 변경해줘야한다. */
   cur->init_priority = new_priority;
   /* donate 받은 pirority도 고려하여 priority를 재설정한다. */
@@ -620,33 +1794,57 @@ thread_get_priority (void)
 
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_set_nice (int nice) 
 {
-  /* Not yet implemented. */
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  if (nice < NICE_MIN)
+    nice = NICE_MIN;
+  else if (nice > NICE_MAX)
+    nice = NICE_MAX;
+
+  /* timer interrupt에서도 nice와 priority를 사용하므로
+     interrupt를 끄고 갱신한다. */
+  old_level = intr_disable ();
+  /* cfs에서는 지금까지 실행한 시간을 이전 가중치로 반영해 둔다. */
+  cfs_update_curr (cur);
+  cur->nice = nice;
+  if (thread_cfs)
+    test_max_priority ();
+  if (thread_mlfqs)
+    {
+      mlfqs_priority (cur);
+      test_max_priority ();
+    }
+  intr_set_level (old_level);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int load = fp_to_int_round (mult_mixed (load_avg, 100));
+  intr_set_level (old_level);
+  return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int recent = fp_to_int_round (mult_mixed (thread_current ()->recent_cpu, 100));
+  intr_set_level (old_level);
+  return recent;
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -671,6 +1869,24 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* 할 일이 없는 동안 빈 page들을 미리 0으로 채워 둔다. page 하나를
+         채울 때마다 interrupt를 잠깐 켜서 그 사이에 깨어난 스레드가
+         있는지 확인한다. idle 스레드는 ready queue에 없으므로 깨어난
+         스레드의 우선순위와 상관없이 선점이 일어나지 않는다. 따라서
+         ready queue가 비어있지 않으면 채우기를 멈추고 thread_block()으로
+         돌아가 그 스레드에게 CPU를 넘긴다. */
+      while (ready_thread_cnt == 0 && palloc_zero_idle ())
+        {
+          intr_enable ();
+          intr_disable ();
+        }
+      if (ready_thread_cnt > 0)
+        continue;
+
+      /* tickless 모드라면 다음으로 깨어날 스레드가 있을 때까지
+         주기적인 timer interrupt를 멈춘다. */
+      timer_idle_enter ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -732,6 +1948,9 @@ init_thread (struct thread *t, const char *name, int priority)
   ASSERT (name != NULL);
 
   memset (t, 0, sizeof *t);
+  /* 이미 이 page를 스택으로 쓰고 있는 initial_thread는 제외한다. */
+  if (t != running_thread ())
+    stack_fill (t);
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
@@ -746,9 +1965,24 @@ init_thread (struct thread *t, const char *name, int priority)
   t->run_file = NULL;
   /* priority scheduling 관련 PCB멤버 초기화 */
   t->init_priority = priority;
-  t->wait_on_lock = NULL;
-  list_init (&t->donations);
+  t->wait_queue = NULL;
+  t->block_kind = BLOCK_NONE;
+  t->stat_since = timer_ticks ();
+  heap_init (&t->held_locks, cmp_hold_priority, NULL);
   t->next_mapid = 0;
+  /* 유저 스레드 관련 PCB멤버 초기화. thread_create 시스템콜로 만든
+     스레드라면 userprog/process.c에서 proc을 main 스레드로 바꾼다. */
+  t->proc = t;
+  list_init (&t->uthread_list);
+  sema_init (&t->uthread_sema, 0);
+  lock_init (&t->vm_lock);
+  lock_init (&t->fdt_lock);
+  t->uthread_slot = -1;
+  /* mlfqs 관련 PCB멤버 초기화 */
+  t->nice = NICE_DEFAULT;
+  t->recent_cpu = 0;
+  t->mlfqs_dirty = false;
+  t->mlfqs_epoch = mlfqs_epoch;
 
 
 }
@@ -774,10 +2008,12 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  struct thread *next = ready_queue_pop ();
+
+  if (next == NULL)
     return idle_thread;
   else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+    return next;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -804,10 +2040,23 @@ thread_schedule_tail (struct thread *prev)
   ASSERT (intr_get_level () == INTR_OFF);
 
   /* Mark us as running. */
+  thread_stat_update (cur);
   cur->status = THREAD_RUNNING;
 
   /* Start new time slice. */
   thread_ticks = 0;
+  if (thread_cfs && cur->edf_period == 0)
+    {
+      cur->exec_start = timer_ns ();
+      cur->slice_exec = 0;
+    }
+
+  /* FPU 상태는 처음 사용할 때 #NM에서 바꾼다. */
+  fpu_switch (cur);
+
+  /* idle thread에서 빠져나왔다면 tickless idle 동안 밀린 ticks를 보정한다. */
+  if (prev != NULL && prev == idle_thread)
+    timer_idle_exit ();
 
 #ifdef USERPROG
   /* Activate the new address space. */
@@ -822,7 +2071,10 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
     {
       ASSERT (prev != cur);
-      //palloc_free_page (prev);
+      /* 부모가 아직 exit status를 읽어야 한다면 부모가 thread_release()할 때
+         반환한다. */
+      if (prev->released)
+        thread_page_free (prev);
     }
 }
 
@@ -844,6 +2096,17 @@ schedule (void)
   ASSERT (cur->status != THREAD_RUNNING);
   ASSERT (is_thread (next));
 
+  /* CPU를 내어주는 이유에 따라 context switch 횟수를 센다. */
+  if (cur != next)
+    {
+      if (cur->preempted)
+        cur->involuntary_switches++;
+      else
+        cur->voluntary_switches++;
+      trace_event (TRACE_SWITCH, cur->tid, next->tid, cur->status);
+    }
+  cur->preempted = false;
+
   if (cur != next)
     prev = switch_threads (cur, next);
   thread_schedule_tail (prev);
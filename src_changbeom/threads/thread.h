@@ -4,8 +4,10 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include <thread-stat.h>
 #include "synch.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/heap.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -16,6 +18,15 @@ enum thread_status
     THREAD_DYING        /* About to be destroyed. */
   };
 
+/* 스레드가 BLOCKED 상태가 된 이유. 스케줄러 통계에 사용한다. */
+enum block_kind
+  {
+    BLOCK_NONE,         /* Not blocked. */
+    BLOCK_SYNC,         /* Waiting on a semaphore, lock or condition. */
+    BLOCK_SLEEP,        /* Sleeping in timer_sleep(). */
+    BLOCK_OTHER         /* Blocked by thread_block() for another reason. */
+  };
+
 /* Thread identifier type.
    You can redefine this to whatever type you like. */
 typedef int tid_t;
@@ -25,8 +36,16 @@ typedef int tid_t;
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
+
+/* mlfqs와 cfs에서 사용하는 nice 값의 범위. */
+#define NICE_MIN -20                    /* Lowest nice. */
+#define NICE_DEFAULT 0                  /* Default nice. */
+#define NICE_MAX 20                     /* Highest nice. */
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) ;
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+void donate_priority (void);
+void refresh_priority (void);
+void thread_refresh_priority (struct thread *t);
+void test_max_priority (void);
 
 
 static struct thread *idle_thread;
@@ -116,6 +135,10 @@ struct thread
     /* 프로세스가 종료 유무 확인 */
     bool exited;
 
+    /* 부모가 더 이상 이 PCB를 참조하지 않으면 true.
+       이 스레드가 종료되면 thread page를 바로 반환한다. */
+    bool released;
+
     /* exit 세마포어 */
     struct semaphore exit_sema;
            
@@ -138,14 +161,111 @@ struct thread
     /* alarm clock을 구현하기 위해 프로세스를 재울 시간을 저장함 */
     int64_t wakeup_tick;
 
-    int init_priority;
+    /* timer_msleep() 등으로 잠들었을 때 깨어날 시각 (timer_ns() 기준, ns). */
+    int64_t wakeup_ns;
 
-    struct lock *wait_on_lock;
+    /* wakeup_tick 또는 wakeup_ns 순서로 정렬되는 sleep heap의 element */
+    struct heap_elem sleep_elem;
 
-    struct list donations;
+    int init_priority;
 
-    struct list_elem donation_elem;
+    /* 이 thread가 점유하고 있는 lock들의 lock_hold. lock을 기다리는 thread들이
+       donate한 최대 우선순위 순서의 max heap이다. */
+    struct heap held_locks;
+
+    /* semaphore, lock, condition variable, rwlock을 기다리는 동안 들어가는
+       wait queue와 그 heap element. 기다리고 있지 않으면 wait_queue는 NULL이다.
+       wait queue의 holds를 따라가면 priority를 donate할 thread들을 찾을 수 있다. */
+    struct wait_queue *wait_queue;
+    struct heap_elem wait_elem;
+    unsigned wait_seq;                  /* 같은 우선순위끼리의 FIFO 순서. */
+    bool rw_write;                      /* rwlock을 쓰기로 기다리면 true. */
+    struct lock_hold *rw_hold;          /* 읽기로 점유할 때 쓸, 미리 할당한
+                                           lock_hold. 없으면 NULL. */
+    struct semaphore *cancel_sema;      /* sema_down_cancelable()로 기다리는
+                                           semaphore, 아니면 NULL. */
+
+    /* 스케줄러 통계. 시간은 timer tick 단위이다. run_ticks는 thread_tick()에서
+       세고, 나머지 시간은 상태가 바뀔 때 stat_since부터 지난 시간을 더한다. */
+    int64_t run_ticks;
+    int64_t ready_ticks;
+    int64_t max_ready_ticks;
+    int64_t sync_ticks;
+    int64_t sleep_ticks;
+    int64_t other_ticks;
+    unsigned voluntary_switches;
+    unsigned involuntary_switches;
+    int64_t stat_since;                 /* 현재 상태가 시작된 tick. */
+    enum block_kind block_kind;         /* BLOCKED 상태인 이유. */
+    bool preempted;                     /* 선점당해서 양보하는 중이면 true. */
+
+    /* mlfqs 스케줄링에 사용하는 값들.
+       recent_cpu는 17.14 고정 소수점 형식으로 저장한다. */
+    int nice;
+    int recent_cpu;
+
+    /* 마지막 우선순위 재계산 이후 recent_cpu가 바뀐 스레드들의 리스트 element.
+       4 tick마다 이 리스트에 있는 스레드들만 우선순위를 다시 계산한다. */
+    bool mlfqs_dirty;
+    struct list_elem dirty_elem;
+    unsigned mlfqs_epoch;               /* 마지막으로 재계산된 mlfqs_epoch. */
+
+    /* EDF 스케줄링의 주기이자 상대 deadline. timer tick 단위이다.
+       thread_create_periodic()으로 만든 스레드만 0이 아니다. */
+    int64_t edf_period;
+
+    /* 스레드는 EDF와 cfs 중 한 클래스로만 스케줄되므로 두 클래스의 값들이
+       공간을 함께 쓴다. edf_period가 0이 아닌 스레드만 edf_ 멤버를,
+       cfs 모드에서 edf_period가 0인 스레드만 cfs 멤버를 사용한다. */
+    union
+      {
+        /* cfs 스케줄링에 사용하는 값들. 시간은 timer_ns() 기준 ns 단위이다. */
+        struct
+          {
+            int64_t vruntime;           /* nice 가중치로 나눈 누적 실행 시간. */
+            int64_t exec_start;         /* 마지막으로 실행 시간을 반영한 시각. */
+            int64_t slice_exec;         /* 이번에 CPU를 받은 뒤 실행한 시간. */
+            struct heap_elem cfs_elem;  /* cfs run queue의 element. */
+          };
+
+        /* EDF 스케줄링에 사용하는 값들. 시간은 timer tick 단위이다. */
+        struct
+          {
+            int64_t edf_budget;         /* 주기마다 실행할 수 있는 시간. */
+            int64_t edf_deadline;       /* 현재 job의 절대 deadline. */
+            int64_t edf_runtime;        /* 이번 주기에 남은 budget. */
+            bool edf_throttled;         /* budget을 다 써서 양보하는 중이면 true. */
+            unsigned edf_jobs;          /* 끝낸 job의 수. */
+            unsigned edf_misses;        /* deadline을 넘긴 job의 수. */
+            unsigned edf_overruns;      /* budget을 다 써서 멈춘 횟수. */
+            struct heap_elem edf_elem;  /* EDF run queue의 element. */
+          };
+      };
    
+    /* FXSAVE 영역. 처음 FPU/SSE를 사용할 때 할당된다. (threads/fpu.c) */
+    void *fpu_mem;
+
+    /* 같은 유저 프로세스의 스레드들이 공유하는 vm, mmap_list, FDT, pagedir의
+       주인인 main 스레드. 프로세스를 처음 만든 스레드나 커널 스레드는
+       자기 자신을 가리킨다. 아래의 vm, mmap_list, next_mapid, next_fd와
+       uthread로 시작하는 멤버들은 main 스레드의 것만 사용한다. */
+    struct thread *proc;
+
+    /* thread_create 시스템콜로 만든 유저 스레드들. (userprog/process.c)
+       uthread_list에는 아직 join되지 않은 스레드들이 child_elem으로 들어있다. */
+    struct list uthread_list;
+    int uthread_cnt;                    /* 아직 종료되지 않은 유저 스레드 수. */
+    uint32_t uthread_stacks;            /* 사용 중인 유저 스택 slot의 비트맵. */
+    struct semaphore uthread_sema;      /* 유저 스레드가 종료될 때마다 up. */
+    int uthread_slot;                   /* 유저 스레드의 스택 slot, 아니면 -1. */
+    bool exiting;                       /* 프로세스가 종료 중이면 true. */
+
+    /* vm 해시테이블의 변경과 page fault 처리를 보호한다. */
+    struct lock vm_lock;
+
+    /* FDT와 next_fd의 변경과 조회를 보호한다. */
+    struct lock fdt_lock;
+
     /* 스레드가 가진 가상 주소 공간을 관리하는 해시테이블 */
     struct hash vm;
 
@@ -167,17 +287,40 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler that runs the thread with
+   the smallest weighted virtual runtime.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_tick_idle (int64_t from, int64_t to);
 void thread_print_stats (void);
+void thread_print_stack_stats (void);
+int thread_get_stats (struct thread_stat *, int cnt);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+tid_t thread_create_periodic (const char *name, int64_t period,
+                              int64_t budget, thread_func *, void *);
+void thread_wait_period (void);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
+void thread_release (struct thread *);
+
+/* thread page cache */
+void *thread_page_alloc (void);
+void thread_page_free (void *);
+void thread_reap (void);
+
+/* alarm clock */
+void thread_sleep (int64_t ticks);
+void thread_awake (int64_t ticks);
+void update_next_tick_to_awake (int64_t ticks);
+int64_t get_next_tick_to_awake (void);
 
 struct thread *thread_current (void);
 tid_t thread_tid (void);
@@ -0,0 +1,120 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Ring buffer에 저장하는 event 수. 2의 거듭제곱이어야 한다. */
+#define TRACE_SIZE 4096
+
+/* trace_dump()가 이름을 출력하는 최대 스레드 수. */
+#define TRACE_NAMES_MAX 64
+
+/* Ring buffer에 기록된 event 하나. */
+struct trace_entry
+  {
+    uint64_t tsc;               /* 기록한 시각 (TSC). */
+    uint8_t type;               /* enum trace_type. */
+    int tid;                    /* Event의 대상 스레드. */
+    uint32_t a, b;              /* Type별 인자. */
+  };
+
+static const char *type_names[TRACE_TYPE_CNT] =
+  {
+    "switch", "block", "unblock", "lock-wait", "lock-acquire",
+    "sema-wake", "page-fault",
+  };
+
+bool trace_dump_on_shutdown;
+
+static struct trace_entry trace_buf[TRACE_SIZE];
+
+/* 지금까지 기록한 event 수. 다음 event는 trace_buf의
+   trace_head % TRACE_SIZE 번째 slot에 기록한다. */
+static uint32_t trace_head;
+
+/* trace_dump()가 buffer를 읽는 동안에는 기록하지 않는다. */
+static bool trace_frozen;
+
+/* 이름을 출력할 스레드들. trace_dump()에서만 사용한다. */
+struct trace_name
+  {
+    int tid;
+    char name[16];
+  };
+static struct trace_name trace_names[TRACE_NAMES_MAX];
+
+static void save_name (struct thread *, void *cnt_);
+
+/* TID에 대한 TYPE event를 기록한다.
+   A와 B의 의미는 enum trace_type에 적혀 있다. */
+void
+trace_event (enum trace_type type, int tid, uint32_t a, uint32_t b)
+{
+  enum intr_level old_level;
+  struct trace_entry *e;
+
+  if (trace_frozen)
+    return;
+
+  old_level = intr_disable ();
+  e = &trace_buf[trace_head++ & (TRACE_SIZE - 1)];
+  e->tsc = timer_tsc ();
+  e->type = type;
+  e->tid = tid;
+  e->a = a;
+  e->b = b;
+  intr_set_level (old_level);
+}
+
+/* 기록된 event들을 오래된 것부터 console에 출력한다.
+   출력 형식은 utils/pintos-trace2json이 읽는 형식이다.
+   출력하는 동안에는 새 event를 기록하지 않는다. */
+void
+trace_dump (void)
+{
+  enum intr_level old_level;
+  uint32_t start, end, i;
+  int name_cnt = 0;
+  int n;
+
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  trace_frozen = true;
+  end = trace_head;
+  thread_foreach (save_name, &name_cnt);
+  intr_set_level (old_level);
+
+  start = end > TRACE_SIZE ? end - TRACE_SIZE : 0;
+  printf ("TRACE: begin %"PRIu64" %"PRIu32" %"PRIu32"\n",
+          timer_tsc_hz (), end - start, end);
+  for (n = 0; n < name_cnt; n++)
+    printf ("TRACE: thread %d %s\n", trace_names[n].tid, trace_names[n].name);
+  for (i = start; i != end; i++)
+    {
+      struct trace_entry *e = &trace_buf[i & (TRACE_SIZE - 1)];
+      printf ("TRACE: %"PRIu64" %s %d %"PRIu32" %"PRIu32"\n",
+              e->tsc, type_names[e->type], e->tid, e->a, e->b);
+    }
+  printf ("TRACE: end\n");
+
+  trace_frozen = false;
+}
+
+/* T의 tid와 이름을 trace_names[]에 저장한다. thread_foreach()에서 호출한다. */
+static void
+save_name (struct thread *t, void *cnt_)
+{
+  int *cnt = cnt_;
+
+  if (*cnt < TRACE_NAMES_MAX)
+    {
+      trace_names[*cnt].tid = t->tid;
+      strlcpy (trace_names[*cnt].name, t->name, sizeof trace_names[*cnt].name);
+      (*cnt)++;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Scheduler event tracing.
+
+   context switch, block/unblock, lock 대기, sema_up, page fault를
+   TSC timestamp와 함께 고정 크기 ring buffer에 기록한다.
+   기록은 interrupt를 끄고 slot 하나를 채우는 것이 전부이므로
+   lock 없이 어디서든 (interrupt handler 안에서도) 호출할 수 있고,
+   buffer가 가득 차면 가장 오래된 event부터 덮어쓴다.
+
+   trace_dump()는 buffer를 "TRACE:"로 시작하는 줄들로 출력하며,
+   utils/pintos-trace2json이 이것을 Chrome trace / Perfetto JSON으로 바꾼다. */
+
+/* Event types.  trace.c의 type_names[]와 순서가 같아야 한다. */
+enum trace_type
+  {
+    TRACE_SWITCH,       /* TID에서 A로 전환. B는 TID의 status. */
+    TRACE_BLOCK,        /* TID가 block됨. A는 enum block_kind. */
+    TRACE_UNBLOCK,      /* TID가 ready가 됨. A는 깨운 스레드의 tid. */
+    TRACE_LOCK_WAIT,    /* TID가 lock A를 기다리기 시작. B는 holder의 tid. */
+    TRACE_LOCK_ACQUIRE, /* TID가 기다리던 lock A를 획득. */
+    TRACE_SEMA_WAKE,    /* sema_up()이 sema A에서 TID를 깨움. B는 깨운 스레드. */
+    TRACE_PAGE_FAULT,   /* TID가 주소 A에서 page fault. B는 fault난 eip. */
+    TRACE_TYPE_CNT
+  };
+
+/* 종료할 때 trace를 출력할지 여부.
+   Controlled by kernel command-line option "-trace". */
+extern bool trace_dump_on_shutdown;
+
+void trace_event (enum trace_type, int tid, uint32_t a, uint32_t b);
+void trace_dump (void);
+
+#endif /* threads/trace.h */
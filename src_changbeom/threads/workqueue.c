@@ -0,0 +1,102 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* 커널이 공용으로 사용하는 work queue. thread_start()에서 만든다. */
+struct workqueue system_wq;
+
+static thread_func worker NO_RETURN;
+
+/* Initializes WORK to run FUNC, passing AUX, each time it is
+   queued. */
+void
+work_init (struct work *work, work_func *func, void *aux)
+{
+  ASSERT (work != NULL);
+  ASSERT (func != NULL);
+
+  work->func = func;
+  work->aux = aux;
+  work->pending = false;
+}
+
+/* Initializes WQ and starts WORKER_CNT worker threads named NAME
+   at the given PRIORITY to run the works queued on it.  Returns
+   true if successful, false if a worker thread could not be
+   created.  NAME must remain valid as long as WQ is in use. */
+bool
+workqueue_create (struct workqueue *wq, const char *name, int priority,
+                  int worker_cnt)
+{
+  int i;
+
+  ASSERT (wq != NULL);
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+  ASSERT (worker_cnt > 0);
+
+  wq->name = name;
+  list_init (&wq->works);
+  sema_init (&wq->avail, 0);
+
+  for (i = 0; i < worker_cnt; i++)
+    if (thread_create (name, priority, worker, wq) == TID_ERROR)
+      return false;
+  return true;
+}
+
+/* Queues WORK on WQ to be run by one of WQ's worker threads.
+   Returns true if WORK was queued, false if WORK was already
+   pending, in which case it will run only once.
+
+   This function may be called from an interrupt handler.  If a
+   worker has a higher priority than the running thread, it runs
+   as soon as the handler returns. */
+bool
+work_queue (struct workqueue *wq, struct work *work)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (wq != NULL);
+  ASSERT (work != NULL);
+
+  old_level = intr_disable ();
+  if (!work->pending)
+    {
+      work->pending = true;
+      list_push_back (&wq->works, &work->elem);
+      sema_up (&wq->avail);
+      queued = true;
+    }
+  intr_set_level (old_level);
+  return queued;
+}
+
+/* Worker thread.  Runs the works queued on WQ_ in order. */
+static void
+worker (void *wq_)
+{
+  struct workqueue *wq = wq_;
+
+  /* mlfqs와 cfs에서는 우선순위를 직접 정할 수 없으므로 nice를 가장 낮게
+     해서 다른 스레드들보다 먼저 실행되게 한다. */
+  if (thread_mlfqs || thread_cfs)
+    thread_set_nice (NICE_MIN);
+
+  for (;;)
+    {
+      enum intr_level old_level;
+      struct work *work;
+
+      sema_down (&wq->avail);
+
+      old_level = intr_disable ();
+      work = list_entry (list_pop_front (&wq->works), struct work, elem);
+      work->pending = false;
+      intr_set_level (old_level);
+
+      /* 실행 중에 다시 큐에 넣으면 이번 실행이 끝난 뒤에 한 번 더 실행된다. */
+      work->func (work->aux);
+    }
+}
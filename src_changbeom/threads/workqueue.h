@@ -0,0 +1,46 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* Kernel work queues.
+
+   interrupt handler에서 오래 걸리는 일을 직접 하지 않고 work로 넘기면,
+   work queue의 worker 스레드가 interrupt가 켜진 스레드 문맥에서 실행한다.
+   work_queue()는 interrupt handler에서도 호출할 수 있다.
+
+   work는 호출하는 쪽이 가지고 있는 구조체이므로 큐에 넣을 때 동적 할당이
+   필요 없고, 큐는 절대 가득 차지 않는다. 이미 큐에 들어가 있는 work를
+   다시 넣으면 한 번만 실행된다. */
+
+/* Function run by a worker thread. */
+typedef void work_func (void *aux);
+
+/* A unit of deferred work. */
+struct work
+  {
+    work_func *func;                    /* Function to run. */
+    void *aux;                          /* Argument to FUNC. */
+    bool pending;                       /* In a queue, not yet started? */
+    struct list_elem elem;              /* Element in workqueue's list. */
+  };
+
+/* A queue of work run by one or more worker threads. */
+struct workqueue
+  {
+    const char *name;                   /* Worker thread name. */
+    struct list works;                  /* Pending works, oldest first. */
+    struct semaphore avail;             /* Number of pending works. */
+  };
+
+/* 커널이 공용으로 사용하는 PRI_MAX 우선순위의 work queue. */
+extern struct workqueue system_wq;
+
+void work_init (struct work *, work_func *, void *aux);
+bool workqueue_create (struct workqueue *, const char *name,
+                       int priority, int worker_cnt);
+bool work_queue (struct workqueue *, struct work *);
+
+#endif /* threads/workqueue.h */
@@ -4,7 +4,9 @@
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "userprog/process.h"
+#include "userprog/syscall.h"
 #include "vm/page.h"
 
 /* Number of page faults processed. */
@@ -47,8 +49,7 @@ exception_init (void)
   intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
   intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
   intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-  intr_register_int (7, 0, INTR_ON, kill,
-                     "#NM Device Not Available Exception");
+  /* #NM Device Not Available Exception is handled by fpu_init(). */
   intr_register_int (11, 0, INTR_ON, kill, "#NP Segment Not Present");
   intr_register_int (12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
   intr_register_int (13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -91,7 +92,8 @@ kill (struct intr_frame *f)
       printf ("%s: dying due to interrupt %#04x (%s).\n",
               thread_name (), f->vec_no, intr_name (f->vec_no));
       intr_dump_frame (f);
-      thread_exit (); 
+      /* 같은 프로세스의 다른 스레드들도 종료되도록 exit()으로 죽인다. */
+      exit (-1); 
 
     case SEL_KCSEG:
       /* Kernel's code segment, which indicates a kernel bug.
@@ -106,7 +108,7 @@ kill (struct intr_frame *f)
          kernel. */
       printf ("Interrupt %#04x (%s) in unknown segment %04x\n",
              f->vec_no, intr_name (f->vec_no), f->cs);
-      thread_exit ();
+      exit (-1);
     }
 }
 
@@ -138,6 +140,8 @@ page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
+  trace_event (TRACE_PAGE_FAULT, thread_current ()->tid,
+               (uintptr_t) fault_addr, (uintptr_t) f->eip);
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
@@ -153,16 +157,27 @@ page_fault (struct intr_frame *f)
 
   /* read only 페이지에 대한 접근이 아닐 경우 (not_present 참조)*/
   if (not_present) {
+    /* vm 해시테이블은 같은 프로세스의 스레드들이 공유하므로 lock을 잡는다.
+       munmap처럼 lock을 잡은 채로 유저 메모리에 접근하다 fault가 날 수도 있다. */
+    struct lock *vm_lock = &thread_current ()->proc->vm_lock;
+    bool locked = !lock_held_by_current_thread (vm_lock);
+    bool success;
+
+    if (locked)
+      lock_acquire (vm_lock);
     /* 페이지 폴트가 일어난 주소에 대한 vm_entry 구조체 탐색 */
     vme = find_vme (fault_addr);
-    /* bad address (비정상적인 가상 주소 접근 시) 프로세스 종료 */
-    if (vme == NULL)
-      exit (-1);
 
     /* vm_entry를 인자로 넘겨주며 handle_mm_fault() 호출 */
     /* 제대로 파일이 물리 메모리에 로드 되고 맵핑 됐는지 검사 */ 
     /* file을 읽어오지 못하거나, 페이지 pool이 가득 차 물리페이지에 맵핑을 못한경우 */
-    if (handle_mm_fault (vme) == false)
+    /* lock을 기다리는 동안 같은 프로세스의 다른 스레드가 이미 로드했을 수 있다. */
+    success = vme != NULL && (vme->is_loaded || handle_mm_fault (vme));
+    if (locked)
+      lock_release (vm_lock);
+
+    /* bad address (비정상적인 가상 주소 접근 시) 프로세스 종료 */
+    if (!success)
       exit (-1);
   } else {
     /* present인 페이지를 접근하다가 page_fault가 난 경우는 모두 죽여버려야함.
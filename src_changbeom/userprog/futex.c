@@ -0,0 +1,148 @@
+#include "userprog/futex.h"
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* 유저 프로그램의 mutex, condition variable을 위한 futex.
+   기다리는 스레드들은 (프로세스, 유저 가상 주소)를 key로 하는
+   hash bucket에 들어간다. 같은 bucket에 다른 key의 스레드들도 섞여 있을 수
+   있으므로 깨울 때는 key가 같은 스레드만 골라서 깨운다. */
+
+#define FUTEX_BUCKETS 64
+
+/* 같은 hash 값을 가진 futex들을 기다리는 스레드들. */
+struct futex_bucket
+  {
+    struct lock lock;
+    struct list waiters;                /* List of struct futex_waiter. */
+  };
+
+/* futex_wait()으로 잠든 스레드 하나. 잠든 스레드의 커널 스택에 있다. */
+struct futex_waiter
+  {
+    struct list_elem elem;
+    struct thread *thread;
+    struct thread *proc;                /* Key: process. */
+    int *addr;                          /* Key: user virtual address. */
+    struct semaphore sema;
+  };
+
+static struct futex_bucket buckets[FUTEX_BUCKETS];
+
+/* PROC의 유저 가상 주소 ADDR에 해당하는 bucket을 반환한다. */
+static struct futex_bucket *
+bucket_of (struct thread *proc, int *addr)
+{
+  return &buckets[hash_int ((uintptr_t) addr ^ (uintptr_t) proc)
+                  % FUTEX_BUCKETS];
+}
+
+/* Initializes the futex buckets. */
+void
+futex_init (void)
+{
+  int i;
+
+  for (i = 0; i < FUTEX_BUCKETS; i++)
+    {
+      lock_init (&buckets[i].lock);
+      list_init (&buckets[i].waiters);
+    }
+}
+
+/* If the int at user address ADDR still equals VAL, sleeps until
+   another thread of the same process calls futex_wake() on ADDR
+   and returns 0.  Returns -1 without sleeping if the value has
+   changed or the process is exiting.
+
+   ADDR must have been validated by the caller.  Because the value
+   is read with the bucket lock held, a futex_wake() that follows
+   a store to *ADDR cannot be missed. */
+int
+futex_wait (int *addr, int val)
+{
+  struct thread *cur = thread_current ();
+  struct futex_bucket *b = bucket_of (cur->proc, addr);
+  struct futex_waiter w;
+
+  lock_acquire (&b->lock);
+  if (cur->proc->exiting || *addr != val)
+    {
+      lock_release (&b->lock);
+      return -1;
+    }
+  w.thread = cur;
+  w.proc = cur->proc;
+  w.addr = addr;
+  sema_init (&w.sema, 0);
+  list_push_back (&b->waiters, &w.elem);
+  lock_release (&b->lock);
+
+  /* lock을 놓은 뒤에 futex_wake()가 먼저 sema_up 하더라도
+     semaphore 값이 남아있으므로 깨어남을 놓치지 않는다. */
+  sema_down (&w.sema);
+  return 0;
+}
+
+/* Wakes up to CNT threads of the current process sleeping on user
+   address ADDR, highest priority first, and returns the number
+   of threads woken. */
+int
+futex_wake (int *addr, int cnt)
+{
+  struct thread *proc = thread_current ()->proc;
+  struct futex_bucket *b = bucket_of (proc, addr);
+  int woken = 0;
+
+  lock_acquire (&b->lock);
+  while (woken < cnt)
+    {
+      struct futex_waiter *max = NULL;
+      struct list_elem *e;
+
+      for (e = list_begin (&b->waiters); e != list_end (&b->waiters);
+           e = list_next (e))
+        {
+          struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+          if (w->proc == proc && w->addr == addr
+              && (max == NULL || w->thread->priority > max->thread->priority))
+            max = w;
+        }
+      if (max == NULL)
+        break;
+      list_remove (&max->elem);
+      sema_up (&max->sema);
+      woken++;
+    }
+  lock_release (&b->lock);
+  return woken;
+}
+
+/* Wakes every thread of PROC sleeping in futex_wait(), so that
+   they notice PROC is exiting. */
+void
+futex_wake_process (struct thread *proc)
+{
+  int i;
+
+  for (i = 0; i < FUTEX_BUCKETS; i++)
+    {
+      struct futex_bucket *b = &buckets[i];
+      struct list_elem *e;
+
+      lock_acquire (&b->lock);
+      for (e = list_begin (&b->waiters); e != list_end (&b->waiters); )
+        {
+          struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+          e = list_next (e);
+          if (w->proc == proc)
+            {
+              list_remove (&w->elem);
+              sema_up (&w->sema);
+            }
+        }
+      lock_release (&b->lock);
+    }
+}
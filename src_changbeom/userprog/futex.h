@@ -0,0 +1,11 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+#include "threads/thread.h"
+
+void futex_init (void);
+int futex_wait (int *addr, int val);
+int futex_wake (int *addr, int cnt);
+void futex_wake_process (struct thread *proc);
+
+#endif /* userprog/futex.h */
@@ -10,12 +10,14 @@
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
 #include "userprog/syscall.h"
+#include "userprog/futex.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "vm/page.h"
@@ -23,10 +25,29 @@
 #include "filesys/file.h"
 #include "lib/kernel/hash.h"
 
-extern struct lock rw_lock;
+extern struct rwlock rw_lock;
 extern struct lock lru_lock;
 
+/* 한 프로세스에서 동시에 살아있을 수 있는 유저 스레드의 최대 개수 */
+#define UTHREAD_MAX 16
+
+/* 유저 스레드 스택 slot 사이의 간격. slot마다 맨 위 page 하나만 스택으로
+   사용하고 나머지는 비워두어서, 스택이 넘치면 다른 스레드의 스택을
+   덮어쓰지 않고 page fault로 프로세스가 종료되게 한다. */
+#define UTHREAD_STACK_GAP (16 * PGSIZE)
+
+/* thread_create 시스템콜이 새 커널 스레드에게 넘겨주는 시작 정보 */
+struct uthread_start
+  {
+    void (*eip) (void);                 /* 유저 모드 시작 주소. */
+    void *esp;                          /* 유저 스택 포인터. */
+    struct thread *proc;                /* 프로세스의 main 스레드. */
+    int slot;                           /* 스택 slot. */
+  };
+
 static thread_func start_process NO_RETURN;
+static thread_func start_uthread NO_RETURN;
+static void uthread_stack_free (struct thread *proc, int slot);
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 int _get_argc(char* file_name);
 char** _get_argv(char* file_name);
@@ -40,7 +61,7 @@ bool handle_mm_fault (struct vm_entry *vme);
 static bool install_page (void *upage, void *kpage, bool writable);
 
 void do_munmap (struct mmap_file *mmap_file) {
-  struct thread *cur = thread_current ();
+  struct thread *cur = thread_current ()->proc;
   struct list_elem *vm_elem = NULL;
 
   /* mmap_list를 순회하여 vme를 해제함 */ 
@@ -50,22 +71,30 @@ void do_munmap (struct mmap_file *mmap_file) {
 
     /* vme가 가리키는 가상주소에 대한 물리 페이지가 존재하고, dirty하면 write-back을 함 */
     struct vm_entry *vme = list_entry (vm_elem, struct vm_entry, mmap_elem);
+    void *kaddr;
+
+    /* rw_lock을 잡은 채로 유저 주소에 접근하면 page fault가 날 수 있으므로
+       lru_lock으로 eviction을 막고 커널 주소로 write-back 한다.
+       lock 순서는 vm_lock -> lru_lock -> rw_lock 이다. */
+    lock_acquire (&lru_lock);
     if (vme->is_loaded) {
+      kaddr = pagedir_get_page (cur->pagedir, vme->vaddr);
       if (pagedir_is_dirty (cur->pagedir, vme->vaddr)) {
-        lock_acquire (&rw_lock);
-        file_write_at (vme->file, vme->vaddr, vme->read_bytes, vme->offset);
-        lock_release (&rw_lock);
+        rwlock_acquire_write (&rw_lock);
+        file_write_at (vme->file, kaddr, vme->read_bytes, vme->offset);
+        rwlock_release_write (&rw_lock);
       }
       /* load 된 경우에는 해당 페이지 해제 */
-      free_page (pagedir_get_page (cur->pagedir, vme->vaddr));
+      free_page (kaddr);
     }
+    lock_release (&lru_lock);
     
     /* vm_elem 을 mmap_list에서 제거한다 */
     list_remove (vm_elem);
     /* hash table에서 vme를 제거한다 */
     delete_vme (&cur->vm, vme);
     /* vme에 할당된 동적 메모리를 해제한다 */
-    free (vme);
+    kmem_cache_free (vme_cache, vme);
 
     vm_elem = next_elem;
   }
@@ -74,7 +103,7 @@ void do_munmap (struct mmap_file *mmap_file) {
   list_remove (&mmap_file->elem);
   /* mmap_file에 할당된 동적 메모리를 해제한다 */
   file_close (mmap_file->file);
-  free (mmap_file);
+  kmem_cache_free (mmap_file_cache, mmap_file);
 }
 
 bool handle_mm_fault (struct vm_entry *vme) {
@@ -123,9 +152,14 @@ bool handle_mm_fault (struct vm_entry *vme) {
    해당 파일 객체를 해당 프로세스의 FDT에 추가해주는 함수
    파일 디스크립터 번호를 리턴함 */
 int process_add_file (struct file *f) {
-  struct thread *cur = thread_current ();
+  /* FDT와 next_fd는 같은 프로세스의 스레드들이 공유하므로 main 스레드의 것을
+     사용하고 main 스레드의 fdt_lock으로 보호함 */
+  struct thread *cur = thread_current ()->proc;
+  int current_fd;
+
+  lock_acquire (&cur->fdt_lock);
   // 파일 객체가 저장될 FDT entry번호를 저장함.
-  int current_fd = cur->next_fd;
+  current_fd = cur->next_fd;
   
   // next_fd 번째 자리 FDT entry에 해당 파일 객체 포인터를 저장함.
   cur->FDT[cur->next_fd] = f;
@@ -138,30 +172,51 @@ int process_add_file (struct file *f) {
     /* 수식이 복잡하지만 이렇게 하면 2~(FILE_MAX-1) 를 돌면서 next_fd를 setting할 수 있음 */
     cur->next_fd = (cur->next_fd + 1 - 2) % (FILE_MAX - 2) + 2;
     /* 한바퀴 돌고도 빈 FDT entry를 못찾으면 -1 리턴 */
-    if (cur->next_fd == current_fd) 
+    if (cur->next_fd == current_fd) {
+      lock_release (&cur->fdt_lock);
       return -1;
+    }
   } while (cur->FDT[cur->next_fd] != NULL);
+  lock_release (&cur->fdt_lock);
   
   // 리턴 값으로 해당 파일을 저장한 FD number를 리턴함
   return current_fd;
 }
 
-/* 파일 디스크립터 숫자를 넘겨주면 그에 해당하는 파일 객체 포인터를 리턴해줌 */
+/* 파일 디스크립터 숫자를 넘겨주면 그에 해당하는 파일 객체 포인터를 리턴해줌
+   같은 프로세스의 다른 스레드가 그 사이에 close()해도 해제되지 않도록
+   file_pin()으로 참조를 늘려서 돌려주므로, 다 쓰면 참조를 놓아야 함 */
 struct file * process_get_file (int fd) {
+  struct thread *proc = thread_current ()->proc;
+  struct file *file;
+
+  if (fd < 0 || fd >= FILE_MAX)
+    return NULL;
   /* 해당 엔트리에 파일이 있으면 파일 객체 포인터가 리턴되고,
      파일 객체가 없는 경우에는 해당 엔트리에 null값이 저장되어있으므로 null이 리턴됨 */
-  return thread_current ()->FDT[fd];
+  lock_acquire (&proc->fdt_lock);
+  file = proc->FDT[fd];
+  if (file != NULL)
+    file_pin (file);
+  lock_release (&proc->fdt_lock);
+  return file;
 }
 
 /* 파일을 닫기 위해 파일 디스크립터를 해제함 */
 void process_close_file (int fd) {
-  struct file *file = process_get_file (fd);
-  /* 닫고자 하는 파일의 inode reference count를 1내림
-     inode는 근데 뭐임? */
-  file_close (file);
-  /* 해당 FDT의 엔트리를 null 값으로 바꿈 */
-  thread_current ()->FDT[fd] = NULL;
+  struct thread *proc = thread_current ()->proc;
+  struct file *file;
 
+  if (fd < 0 || fd >= FILE_MAX)
+    return;
+  /* 해당 FDT의 엔트리를 null 값으로 바꿈 */
+  lock_acquire (&proc->fdt_lock);
+  file = proc->FDT[fd];
+  proc->FDT[fd] = NULL;
+  lock_release (&proc->fdt_lock);
+  /* FDT가 가지고 있던 참조를 놓음. 다른 스레드가 아직 사용 중이면
+     그 스레드가 참조를 놓을 때 해제됨 */
+  file_close (file);
 }
 
 /* Starts a new thread running a user program loaded from
@@ -176,7 +231,7 @@ process_execute (const char *file_name)
 
   /* Make a copy of FILE_NAME.
      Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
+  fn_copy = thread_page_alloc ();
   if (fn_copy == NULL)
     return TID_ERROR;
   strlcpy (fn_copy, file_name, PGSIZE);
@@ -193,7 +248,7 @@ process_execute (const char *file_name)
   tid = thread_create (_trimed_file_name, PRI_DEFAULT, start_process, fn_copy);
   
   if (tid == TID_ERROR) {
-    palloc_free_page (fn_copy);
+    thread_page_free (fn_copy);
   }
   return tid;
 }
@@ -270,7 +325,7 @@ start_process (void *file_name_)
   // get_argv() 의 리턴값으로 받아온 동적할당 메모리 주소를 해제함.
   /* file_name_에 대한 해제는 process_execute()에서 수행
      하는 줄 알았는데 process_execute()가 비정상 종료 될 때만 해제 해주는 거였음*/
-  palloc_free_page (file_name_);
+  thread_page_free (file_name_);
   free (argv);
 
 
@@ -410,7 +465,9 @@ struct thread *get_child_process (int pid)
 void remove_child_process (struct thread *cp) 
 {
   list_remove (&cp->child_elem);
-  palloc_free_page(cp);
+  /* 자식이 아직 완전히 종료되지 않았을 수도 있으므로
+     자식의 page는 종료가 끝난 뒤에 반환되도록 한다. */
+  thread_release (cp);
 }
 
 
@@ -440,8 +497,12 @@ process_wait (tid_t child_pid)
   }
 
   /*  wait하고자 하는 자식 프로세스가 아직 종료가 안되었다면 
-      프로세스가 종료되고 sema_up될 때까지 block상태로 기다린다.*/
-  sema_down(&child->exit_sema);
+      프로세스가 종료되고 sema_up될 때까지 block상태로 기다린다.
+      기다리는 동안 같은 프로세스의 다른 스레드가 exit()을 호출하면
+      깨어나서 -1을 리턴하고, 유저 모드로 돌아가기 전에 종료된다. */
+  if (!sema_down_cancelable (&child->exit_sema,
+                             &thread_current ()->proc->exiting))
+    return -1;
   
   /*  자식 프로세스 종료 코드를 받아오고 
       자식 프로세스의 PCB를 해제하는 작업을 함. */
@@ -457,9 +518,41 @@ process_exit (void)
 {
   struct thread *cur = thread_current ();
   struct list_elem *elem = NULL;
+  enum intr_level old_level;
   uint32_t *pd;
   int i;
   
+  /* 유저 스레드는 자기 스택만 반환한다. FDT, vm, pagedir은
+     main 스레드의 것을 공유하므로 main 스레드가 종료될 때 해제한다. */
+  if (cur->proc != cur) {
+    struct thread *proc = cur->proc;
+
+    uthread_stack_free (proc, cur->uthread_slot);
+    cur->FDT = NULL;
+    /* main 스레드가 pagedir을 해제하기 전에 이 스레드가 더 이상
+       그 pagedir을 사용하지 않도록 먼저 커널 pagedir로 바꾼다. */
+    cur->pagedir = NULL;
+    pagedir_activate (NULL);
+
+    old_level = intr_disable ();
+    proc->uthread_cnt--;
+    sema_up (&proc->uthread_sema);
+    intr_set_level (old_level);
+    return;
+  }
+
+  /* main 스레드는 다른 유저 스레드들이 모두 종료될 때까지 기다린다.
+     exit()을 거치지 않고 종료되는 경우에도 다른 스레드들이 종료되도록 표시한다. */
+  if (cur->uthread_cnt > 0) {
+    cur->exiting = true;
+    process_wake_threads (cur);
+    while (cur->uthread_cnt > 0)
+      sema_down (&cur->uthread_sema);
+  }
+  while (!list_empty (&cur->uthread_list))
+    thread_release (list_entry (list_pop_front (&cur->uthread_list),
+                                struct thread, child_elem));
+
 
   /* FDT에 있는 모든 file 객체들의 inode 의 reference count를 1씩 뺀다
      process_close_file 내부적으로 null값에 대해서 file_close()에 의해 알아서 예외 처리됨.
@@ -481,7 +574,7 @@ process_exit (void)
     }
      /* FDT는 PCB와 같은 페이지에 있는 것이 아닌 따로 할당을 해줬었음.
         고로 따로 페이지 해제를 해줘야함 */
-     palloc_free_page(cur->FDT);
+     thread_page_free (cur->FDT);
   }
   /* load() 함수에 의해 열린 ELF파일 객체를 프로세스 종료 때 해제함.
      이 파일을 해제함으로 다른 프로세스가 ELF파일에 write할 수 있게 허용해줌.
@@ -508,6 +601,257 @@ process_exit (void)
     }
 }
 
+/* 유저 스택 slot SLOT의 스택 page 주소를 반환한다. */
+static uint8_t *
+uthread_stack_page (int slot)
+{
+  return (uint8_t *) PHYS_BASE - (slot + 1) * UTHREAD_STACK_GAP - PGSIZE;
+}
+
+/* PROC의 유저 스택 slot SLOT에 스택 page를 할당하고 매핑한다.
+   스택 맨 위에는 FUNCTION(AUX)를 호출하는 유저 라이브러리의 시작 함수가
+   받을 인자들과 가짜 return address를 넣고, 그 위치를 *ESP에 저장한다.
+   PROC의 vm_lock을 잡은 상태에서 호출해야 한다. */
+static bool
+uthread_stack_setup (struct thread *proc, int slot, void *function, void *aux,
+                     void **esp)
+{
+  uint8_t *upage = uthread_stack_page (slot);
+  struct vm_entry *vme;
+  struct page *page;
+  uint32_t *top;
+
+  ASSERT (lock_held_by_current_thread (&proc->vm_lock));
+
+  page = alloc_page (PAL_USER | PAL_ZERO);
+  if (page == NULL)
+    return false;
+  vme = kmem_cache_alloc (vme_cache);
+  if (vme == NULL || !install_page (upage, page->kaddr, true)) {
+    kmem_cache_free (vme_cache, vme);
+    palloc_free_page (page->kaddr);
+    kmem_cache_free (page_struct_cache, page);
+    return false;
+  }
+
+  memset (vme, 0x00, sizeof *vme);
+  vme->type = VM_ANON;
+  vme->writable = true;
+  vme->vaddr = upage;
+  vme->is_loaded = true;
+  page->vme = vme;
+
+  /* lru list에 넣기 전이므로 swap out 되지 않는다. 커널 주소로 바로 쓴다. */
+  top = (uint32_t *) (page->kaddr + PGSIZE);
+  *--top = (uint32_t) aux;
+  *--top = (uint32_t) function;
+  *--top = 0;
+  *esp = upage + PGSIZE - 3 * sizeof (uint32_t);
+
+  insert_vme (&proc->vm, vme);
+  add_page_to_lru_list (page);
+  return true;
+}
+
+/* PROC의 유저 스택 slot SLOT을 반환한다. */
+static void
+uthread_stack_free (struct thread *proc, int slot)
+{
+  struct vm_entry *vme;
+
+  lock_acquire (&proc->vm_lock);
+  vme = find_vme (uthread_stack_page (slot));
+  if (vme != NULL) {
+    if (vme->is_loaded)
+      free_page (pagedir_get_page (proc->pagedir, vme->vaddr));
+    delete_vme (&proc->vm, vme);
+    kmem_cache_free (vme_cache, vme);
+  }
+  proc->uthread_stacks &= ~(1u << slot);
+  lock_release (&proc->vm_lock);
+}
+
+/* 현재 프로세스에 새 유저 스레드를 만든다. 새 스레드는 자기 유저 스택에서
+   EIP부터 실행하며, 스택에는 FUNCTION과 AUX가 인자로 들어있다.
+   pagedir, vm, FDT는 main 스레드의 것을 공유한다.
+   새 스레드의 tid를 반환하고, 만들 수 없으면 TID_ERROR를 반환한다. */
+tid_t
+process_thread_create (void (*eip) (void), void *function, void *aux)
+{
+  struct thread *proc = thread_current ()->proc;
+  struct uthread_start *us;
+  struct thread *t;
+  enum intr_level old_level;
+  int slot;
+  tid_t tid;
+
+  if (proc->exiting)
+    return TID_ERROR;
+  us = malloc (sizeof *us);
+  if (us == NULL)
+    return TID_ERROR;
+
+  lock_acquire (&proc->vm_lock);
+  for (slot = 0; slot < UTHREAD_MAX; slot++)
+    if (!(proc->uthread_stacks & (1u << slot)))
+      break;
+  if (slot == UTHREAD_MAX
+      || !uthread_stack_setup (proc, slot, function, aux, &us->esp)) {
+    lock_release (&proc->vm_lock);
+    free (us);
+    return TID_ERROR;
+  }
+  proc->uthread_stacks |= 1u << slot;
+  lock_release (&proc->vm_lock);
+
+  us->eip = eip;
+  us->proc = proc;
+  us->slot = slot;
+
+  /* 새 스레드가 종료될 때까지 main 스레드가 기다리도록
+     스레드를 만들기 전에 센다. */
+  old_level = intr_disable ();
+  proc->uthread_cnt++;
+  intr_set_level (old_level);
+
+  tid = thread_create (proc->name, thread_get_priority (), start_uthread, us);
+  if (tid == TID_ERROR) {
+    uthread_stack_free (proc, slot);
+    old_level = intr_disable ();
+    proc->uthread_cnt--;
+    intr_set_level (old_level);
+    free (us);
+    return TID_ERROR;
+  }
+
+  /* 유저 스레드는 wait()의 대상이 아니므로 자식 리스트에서
+     main 스레드의 uthread_list로 옮긴다. 이미 종료되었더라도
+     PCB는 release 되기 전까지 남아있다. */
+  t = get_child_process (tid);
+  old_level = intr_disable ();
+  list_remove (&t->child_elem);
+  list_push_back (&proc->uthread_list, &t->child_elem);
+  intr_set_level (old_level);
+  return tid;
+}
+
+/* thread_create 시스템콜로 만든 유저 스레드를 시작하는 함수. */
+static void
+start_uthread (void *us_)
+{
+  struct uthread_start *us = us_;
+  struct thread *cur = thread_current ();
+  struct intr_frame if_;
+
+  cur->proc = us->proc;
+  cur->uthread_slot = us->slot;
+
+  /* thread_create()가 할당한 FDT 대신 main 스레드의 FDT를 공유한다. */
+  thread_page_free (cur->FDT);
+  cur->FDT = us->proc->FDT;
+  cur->pagedir = us->proc->pagedir;
+  process_activate ();
+
+  memset (&if_, 0, sizeof if_);
+  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.cs = SEL_UCSEG;
+  if_.eflags = FLAG_IF | FLAG_MBS;
+  if_.eip = us->eip;
+  if_.esp = us->esp;
+  free (us);
+
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* 현재 프로세스의 유저 스레드 TID가 종료될 때까지 기다린다.
+   성공하면 0을 반환하고, TID가 현재 프로세스의 유저 스레드가 아니거나
+   자기 자신이거나 이미 join 되었다면 기다리지 않고 -1을 반환한다. */
+int
+process_thread_join (tid_t tid)
+{
+  struct thread *cur = thread_current ();
+  struct thread *t = NULL;
+  struct list_elem *e;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  for (e = list_begin (&cur->proc->uthread_list);
+       e != list_end (&cur->proc->uthread_list); e = list_next (e)) {
+    struct thread *ut = list_entry (e, struct thread, child_elem);
+    if (ut->tid == tid && ut != cur) {
+      t = ut;
+      list_remove (&t->child_elem);
+      break;
+    }
+  }
+  intr_set_level (old_level);
+
+  if (t == NULL)
+    return -1;
+  sema_down (&t->exit_sema);
+  thread_release (t);
+  return 0;
+}
+
+/* 현재 유저 스레드를 종료한다. main 스레드가 호출하면 main 스레드가 pagedir,
+   vm, FDT를 해제하기 전에 다른 유저 스레드들이 모두 스스로 끝날 때까지
+   기다린 뒤 exit(0)으로 프로세스를 종료한다. 기다리는 동안 다른 스레드가
+   exit()을 호출했다면 그 종료 코드가 유지된다. */
+void
+process_thread_exit (void)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur->proc == cur) {
+    while (cur->uthread_cnt > 0)
+      sema_down (&cur->uthread_sema);
+    exit (0);
+    NOT_REACHED ();
+  }
+  thread_exit ();
+}
+
+/* process_wake_threads()가 thread_foreach()로 호출한다. PROC의 다른
+   스레드 T가 sema_down_cancelable()에서 기다리고 있으면 깨운다. */
+static void
+wake_sibling (struct thread *t, void *proc)
+{
+  if (t->proc == proc && t != thread_current ())
+    sema_cancel (t);
+}
+
+/* PROC의 exiting을 true로 바꾼 뒤 호출한다. futex_wait()이나
+   process_wait()처럼 오래 기다릴 수 있는 곳에서 잠든 PROC의 스레드들을
+   깨워서, 유저 모드로 돌아가기 전에 종료되게 한다. */
+void
+process_wake_threads (struct thread *proc)
+{
+  enum intr_level old_level;
+
+  ASSERT (proc->exiting);
+
+  futex_wake_process (proc);
+  old_level = intr_disable ();
+  thread_foreach (wake_sibling, proc);
+  intr_set_level (old_level);
+}
+
+/* 같은 프로세스의 다른 스레드가 exit()을 호출해서 프로세스가 종료 중이면
+   현재 스레드도 종료한다. 유저 모드로 돌아가기 직전에 intr_handler()에서
+   호출하므로, 유저 모드에서 계산만 하고 있는 스레드도 다음 timer
+   interrupt에서 종료된다. */
+void
+process_check_exit (void)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur->proc->exiting) {
+    intr_enable ();
+    exit (cur->proc->exit_status);
+  }
+}
+
 /* Sets up the CPU for running user code in the current
    thread.
    This function is called on every context switch. */
@@ -615,7 +959,7 @@ load (const char *file_name, void (**eip) (void), void **esp)
   
   /* 파일 read, write시 lock을 사용해 동시 접근을 막아야하므로 
      syscall.c 에서 전역변수로 만들었던 rw_lock을 사용하여 lock을 걺 */
-  lock_acquire (&rw_lock);
+  rwlock_acquire_write (&rw_lock);
   /* Open executable file. */
   file = filesys_open (file_name);
   if (file == NULL) 
@@ -712,6 +1056,10 @@ load (const char *file_name, void (**eip) (void), void **esp)
         }
     }
 
+  /* 파일은 다 읽었으므로 stack page를 할당하기 전에 lock을 놓는다.
+     alloc_page()가 eviction을 하면 rw_lock을 다시 잡을 수 있기 때문이다. */
+  rwlock_release_write (&rw_lock);
+
   /* Set up stack. */
   if (!setup_stack (esp))
     goto done;
@@ -725,8 +1073,9 @@ load (const char *file_name, void (**eip) (void), void **esp)
   /* We arrive here whether the load is successful or not. */
   /* ELF 파일에 대한 해제는 process_exit()에서 수행하므로 기존에 있던 file_close()는 없애버림.*/
   //file_close (file);
-  /* elf file load 전에 걸었던 lock 반 */  
-  lock_release (&rw_lock);
+  /* elf file load 전에 걸었던 lock 반납. setup_stack() 전에 이미 놓았을 수 있음 */  
+  if (rwlock_held_by_current_thread (&rw_lock))
+    rwlock_release_write (&rw_lock);
   return success;
 }
 
@@ -827,8 +1176,8 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           return false; 
         } */
            
-      /*  vm_entry 생성 (malloc 사용) */
-      struct vm_entry *vme = (struct vm_entry*)malloc (sizeof (struct vm_entry));
+      /*  vm_entry 생성 (vme_cache 사용) */
+      struct vm_entry *vme = kmem_cache_alloc (vme_cache);
       if (vme == NULL) 
         return false;
 
@@ -882,7 +1231,7 @@ setup_stack (void **esp)
     }
   }
   /* vm_entry 생성 */
-  vme = (struct vm_entry*)malloc (sizeof (struct vm_entry));
+  vme = kmem_cache_alloc (vme_cache);
   if (!vme)
     return false;
   memset (vme, 0x00, sizeof (struct vm_entry));
@@ -14,4 +14,11 @@ int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
 
+/* 유저 스레드 */
+tid_t process_thread_create (void (*eip) (void), void *function, void *aux);
+int process_thread_join (tid_t);
+void process_thread_exit (void) NO_RETURN;
+void process_check_exit (void);
+void process_wake_threads (struct thread *proc);
+
 #endif /* userprog/process.h */
@@ -5,16 +5,22 @@
 #include <list.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "lib/string.h"
 #include "userprog/process.h"
+#include "userprog/futex.h"
 #include "vm/page.h"
 #include "threads/vaddr.h"
+#include "threads/malloc.h"
 
 /* 보다 직관적인 check_address() 를 작성하기 위해 
    각 메모리 영역 시작 주소 값을 USER_START, KERNEL_START로 정의함. */
 #define USER_START      0x08048000
 #define KERNEL_START    0xc0000000
 
+/* threadstat 시스템콜 한 번에 돌려주는 최대 스레드 수 */
+#define THREADSTAT_MAX  256
+
 #define STDIN   0
 #define STDOUT  1
 
@@ -34,20 +40,55 @@ void seek (int fd, unsigned position);
 void close (int fd);
 unsigned tell (int fd);
 mapid_t mmap (int fd, void *addr);
+int nice (int increment);
+int threadstat (struct thread_stat *stats, int cnt);
+int sys_futex_wait (int *addr, int val);
 
 /* read() write() 시스템콜 호출 시 사용될 lock
    disk 같은 공유자원에 접근 할 때는
    critical section, mutex등으로 
-   공유자원에 대한 동시 접근 보호가 필요함 */
+   공유자원에 대한 동시 접근 보호가 필요함
+
+   lock 순서는 vm_lock -> lru_lock -> rw_lock 이다. page fault 처리나
+   eviction이 rw_lock을 잡을 수 있으므로, rw_lock을 잡은 동안에는
+   유저 메모리에 접근하거나 유저 page를 할당하지 않는다. */
+
+/* 유저 문자열 STR을 커널 page로 복사해서 반환한다. rw_lock을 잡은 채로
+   유저 메모리를 읽지 않도록 파일 이름은 이것으로 복사해서 넘긴다.
+   PGSIZE보다 긴 문자열은 잘린다. 페이지를 할당하지 못하면 NULL을 반환하고,
+   반환한 페이지는 palloc_free_page()로 해제해야 한다. */
+static char *
+copy_in_string (const char *str)
+{
+  char *kstr = palloc_get_page (0);
+
+  if (kstr != NULL)
+    strlcpy (kstr, str, PGSIZE);
+  return kstr;
+}
+
+/* process_get_file()로 얻은 FILE의 참조를 놓는다. 그 사이에 같은 프로세스의
+   다른 스레드가 close()해서 마지막 참조가 되었다면, inode를 닫아야 하므로
+   rw_lock을 잡고 닫는다. */
+static void
+put_file (struct file *file)
+{
+  if (file_unpin (file))
+    return;
+  rwlock_acquire_write (&rw_lock);
+  file_close (file);
+  rwlock_release_write (&rw_lock);
+}
 
 void munmap (int mapping) {
   struct list_elem *elem = NULL;
-  struct thread *cur = thread_current ();
+  struct thread *proc = thread_current ()->proc;
   struct mmap_file *mmap_file = NULL;
 
-  /* mapping에 해당하는 mmap_file을 thread 구조체의 mmap_list를 순회하여 찾는다 */
-  for (elem = list_begin (&cur->mmap_list);
-       elem != list_end (&cur->mmap_list); elem = list_next (elem)) {
+  /* mapping에 해당하는 mmap_file을 main 스레드의 mmap_list를 순회하여 찾는다 */
+  lock_acquire (&proc->vm_lock);
+  for (elem = list_begin (&proc->mmap_list);
+       elem != list_end (&proc->mmap_list); elem = list_next (elem)) {
     struct mmap_file *mm_f = list_entry (elem, struct mmap_file, elem);
     if (mm_f->mapid == mapping) {
       mmap_file = mm_f;
@@ -55,13 +96,13 @@ void munmap (int mapping) {
     }
   }
   /* mapping 에 해당하는 mmap_file을 찾지 못한 경우 종료 */
-  if (mmap_file == NULL)
-    return;
-  else
+  if (mmap_file != NULL)
     do_munmap (mmap_file);
+  lock_release (&proc->vm_lock);
 }
 
 mapid_t mmap (int fd, void *addr) {
+  struct thread *proc = thread_current ()->proc;
   struct mmap_file *mmap_file = NULL;
   struct file *file = NULL;
   off_t offset = 0;
@@ -79,25 +120,29 @@ mapid_t mmap (int fd, void *addr) {
         pg_ofs (addr) == 0 &&
         is_user_vaddr (addr) &&
         check_address (addr) == NULL)) {
+    put_file (file);
     return -1;
   }
   
   /* mmap_file 를 생성하기 위해 메모리 할당 */
-  mmap_file = (struct mmap_file *)malloc (sizeof (struct mmap_file));
+  mmap_file = kmem_cache_alloc (mmap_file_cache);
   if (mmap_file == NULL) {
+    put_file (file);
     return -1;
   }
 
   /* mmap_file 멤버 초기화 */
   memset (mmap_file, 0x00, sizeof (struct mmap_file));
   /* fd + 최대 파일 디스크립터 개수로 mapid 결정*/
-  mmap_file->mapid = thread_current ()->next_mapid++; 
+  lock_acquire (&proc->vm_lock);
+  mmap_file->mapid = proc->next_mapid++; 
   /* 파일이 나중에 close되어도 mmap() 유효성 유지 */
-  lock_acquire (&rw_lock);
+  rwlock_acquire_write (&rw_lock);
   mmap_file->file = file_reopen (file);
-  lock_release (&rw_lock);
+  rwlock_release_write (&rw_lock);
+  put_file (file);
   list_init (&mmap_file->vme_list);
-  list_push_back (&thread_current ()->mmap_list, &mmap_file->elem);
+  list_push_back (&proc->mmap_list, &mmap_file->elem);
 
   read_bytes = file_length (mmap_file->file);
   
@@ -108,8 +153,8 @@ mapid_t mmap (int fd, void *addr) {
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
            
-      /*  vm_entry 생성 (malloc 사용) */
-      struct vm_entry *vme = (struct vm_entry*)malloc (sizeof (struct vm_entry));
+      /*  vm_entry 생성 (vme_cache 사용) */
+      struct vm_entry *vme = kmem_cache_alloc (vme_cache);
       ASSERT(vme != NULL) 
 
       /*  vm_entry 멤버들 설정, 가상페이지가 요구될 때 읽어야할 파일의 오프
@@ -126,13 +171,14 @@ mapid_t mmap (int fd, void *addr) {
 
       /*  insert_vme() 함수를 사용해서 생성한 vm_entry를 해시테이블에 추가 */
       list_push_back (&mmap_file->vme_list, &vme->mmap_elem);
-      insert_vme (&thread_current ()->vm, vme);
+      insert_vme (&proc->vm, vme);
 
       /* Advance. */
       offset += page_read_bytes;
       read_bytes -= page_read_bytes;
       upage += PGSIZE;
   }
+  lock_release (&proc->vm_lock);
   return mmap_file->mapid;
 }
 
@@ -142,7 +188,8 @@ syscall_init (void)
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
   
   /* 핀토스 부팅할 때 init()에 의해 rw_lock이 초기화 될 수 있도록 함 */
-  lock_init (&rw_lock);
+  rwlock_init (&rw_lock);
+  futex_init ();
 }
 
 static void
@@ -251,16 +298,105 @@ syscall_handler (struct intr_frame *f UNUSED)
         munmap ((int)arg[0]);
         break;
 
+     case SYS_NICE :
+        get_argument (esp, arg, 1);
+        f->eax = nice ((int)arg[0]);
+        break;
+
+     case SYS_THREADSTAT :
+        get_argument (esp, arg, 2);
+        /* 검사할 크기가 넘치지 않도록 개수를 먼저 제한하고,
+           검사한 만큼만 복사되도록 같은 개수를 넘겨준다. */
+        if (arg[1] <= 0) {
+          f->eax = 0;
+          break;
+        }
+        if (arg[1] > THREADSTAT_MAX)
+          arg[1] = THREADSTAT_MAX;
+        check_valid_buffer ((void*)arg[0], arg[1] * sizeof (struct thread_stat), esp, true);
+        f->eax = threadstat ((struct thread_stat*)arg[0], arg[1]);
+        break;
+
+     case SYS_TRACEDUMP :
+        trace_dump ();
+        break;
+
+     case SYS_THREAD_CREATE :
+        get_argument (esp, arg, 3);
+        check_address ((void*)arg[0]);
+        f->eax = process_thread_create ((void*)arg[0], (void*)arg[1], (void*)arg[2]);
+        break;
+
+     case SYS_THREAD_JOIN :
+        get_argument (esp, arg, 1);
+        f->eax = process_thread_join ((tid_t)arg[0]);
+        break;
+
+     case SYS_THREAD_EXIT :
+        process_thread_exit ();
+        break;
+
+     case SYS_FUTEX_WAIT :
+        get_argument (esp, arg, 2);
+        check_valid_buffer ((void*)arg[0], sizeof (int), esp, false);
+        f->eax = sys_futex_wait ((int*)arg[0], arg[1]);
+        break;
+
+     case SYS_FUTEX_WAKE :
+        get_argument (esp, arg, 2);
+        f->eax = futex_wake ((int*)arg[0], arg[1]);
+        break;
+
   }
 
 }
 
+/* 현재 프로세스의 nice 값을 increment만큼 올리고 바뀐 nice 값을 반환한다.
+   유저 프로그램은 자신의 우선순위를 낮추는 것만 가능하므로
+   increment가 음수이면 아무것도 바꾸지 않고 -1을 반환한다.
+   nice 값은 mlfqs 스케줄러에서 우선순위 계산에 사용된다. */
+int nice (int increment) {
+  if (increment < 0)
+    return -1;
+  if (increment > NICE_MAX - NICE_MIN)
+    increment = NICE_MAX - NICE_MIN;
+  thread_set_nice (thread_get_nice () + increment);
+  return thread_get_nice ();
+}
+
+/* 살아있는 스레드들의 스케줄러 통계를 최대 cnt개까지 stats에 채우고
+   채운 개수를 반환한다. 통계는 interrupt를 끈 채로 커널 버퍼에 모은 뒤
+   유저 버퍼로 복사하므로, 복사 중에 page fault가 나도 괜찮다.
+   cnt는 1 이상 THREADSTAT_MAX 이하여야 하고, stats는 cnt개만큼
+   check_valid_buffer()로 검사되어 있어야 한다. */
+int threadstat (struct thread_stat *stats, int cnt) {
+  struct thread_stat *buf;
+  int n;
+
+  ASSERT (cnt > 0 && cnt <= THREADSTAT_MAX);
+  buf = malloc (cnt * sizeof *buf);
+  if (buf == NULL)
+    return -1;
+  n = thread_get_stats (buf, cnt);
+  memcpy (stats, buf, n * sizeof *buf);
+  free (buf);
+  return n;
+}
+
+/* addr의 값이 val이면 같은 프로세스의 다른 스레드가 futex_wake()를 호출할 때까지
+   잠든다. futex word는 4바이트 단위로 정렬되어 있어야 한다. */
+int sys_futex_wait (int *addr, int val) {
+  if ((uintptr_t) addr % sizeof (int) != 0)
+    return -1;
+  return futex_wait (addr, val);
+}
+
 /* 파일 디스크립터 사용이 끝나면 
    이 시스템콜을 호출하여 해당 fd의 file object를 해제할 수 있음 */
 void close (int fd) {
-  lock_acquire (&rw_lock);
+  rwlock_acquire_write (&rw_lock);
   process_close_file (fd);  
-  lock_release (&rw_lock);
+  rwlock_release_write (&rw_lock);
   return;
 }
 
@@ -273,8 +409,12 @@ unsigned tell (int fd) {
        만약 null값을 file_tell()에 넘겨서 호출할 경우 assertion발생*/
     return -1;
   } else {
+    unsigned position;
+
     /* file_tell() 내부적으로 file_object->pos 값을 읽어와줌 */
-    return file_tell (file_object);
+    position = file_tell (file_object);
+    put_file (file_object);
+    return position;
   }
 
 }
@@ -293,6 +433,7 @@ void seek (int fd, unsigned position) {
 
     /* 내부적으로 파일 객체의 pos멤버를 position값을 바꾸도록 작동함 */
     file_seek (file_object, position);
+    put_file (file_object);
     return position; 
     // file_seek() 함수가 따로 바꾼 위치 값을 리턴하지 않아서 position 인자값 그대로 사용함
   }
@@ -301,7 +442,7 @@ void seek (int fd, unsigned position) {
 
 /* fd가 나타내는 파일에 내용을 입력할 수 있게 해주는 시스템콜 함수 */
 int write (int fd, void *buffer, unsigned size) {
-  struct file *file_object = process_get_file (fd);
+  struct file *file_object;
   int bytes_write;
   
  
@@ -312,18 +453,43 @@ int write (int fd, void *buffer, unsigned size) {
     putbuf(buffer, size);
     bytes_write = size;
   } else {
-   
-    lock_acquire (&rw_lock);
-    //----------- start critical section ---------------
+    uint8_t *kbuf;
+
+    /* 다른 스레드가 close()해도 쓰는 동안은 해제되지 않도록 참조를 잡아둔다. */
+    file_object = process_get_file (fd);
+    if (file_object == NULL)
+      return -1;
+    /* read()와 마찬가지로 rw_lock을 잡기 전에 유저 buffer를 커널 buffer로
+       복사해서, rw_lock을 잡은 채로 page fault가 나지 않게 한다. */
+    kbuf = palloc_get_page (0);
+    if (kbuf == NULL) {
+      put_file (file_object);
+      return -1;
+    }
+    bytes_write = 0;
+    while (size > 0) {
+      off_t chunk = size < PGSIZE ? size : PGSIZE;
+      off_t n;
+
+      memcpy (kbuf, (uint8_t *) buffer + bytes_write, chunk);
+      rwlock_acquire_write (&rw_lock);
+      //----------- start critical section ---------------
   
-    /* file_write()가 해당 파일에서 buffer에다가 size만큼 읽어와서 읽은 byte수만큼 리턴해줌
-       그럼 파일을 어디서 부터 읽느냐 그건 file object에 pos라는 읽을 위치를 저장해놓은 멤버가 있어서
-       내부적으로 이 pos부터 시작해서 size만큼 읽음 */
-    bytes_write = file_write(file_object, buffer, size);
+      /* file_write()가 kbuf의 내용을 파일에 chunk만큼 써서 쓴 byte수만큼 리턴해줌
+         그럼 파일의 어디서 부터 쓰느냐 그건 file object에 pos라는 위치를 저장해놓은 멤버가 있어서
+         내부적으로 이 pos부터 시작해서 chunk만큼 씀 */
+      n = file_write (file_object, kbuf, chunk);
     
-    //------------ finish critical section -------------
-    lock_release (&rw_lock);
+      //------------ finish critical section -------------
+      rwlock_release_write (&rw_lock);
 
+      bytes_write += n;
+      size -= n;
+      if (n < chunk)
+        break;
+    }
+    palloc_free_page (kbuf);
+    put_file (file_object);
  }
   
   return bytes_write;
@@ -331,7 +497,7 @@ int write (int fd, void *buffer, unsigned size) {
 
 /* fd가 나타내는 파일의 내용을 읽어주는 시스템콜 함수 */
 int read (int fd, void *buffer, unsigned size) {
-  struct file *file_object = process_get_file (fd);
+  struct file *file_object;
   int bytes_read = 0; 
   int i;
 
@@ -351,17 +517,44 @@ int read (int fd, void *buffer, unsigned size) {
     bytes_read = i + 1; 
   
   } else {
-  /* 파일을 읽는 동안 다른 프로세스가 같은 파일에 접근하지 못하도록 lock을 걸음 */
-    lock_acquire (&rw_lock);
-    //---------- start critical section -----------
-
-    /* 해당 파일에서 size크기 만큼 읽고 (혹은 EOF 읽는 지점까지) 
-       buffer주소에 읽어온 내용을 저장하며
-       읽은 byte 수를 반환함. */
-    bytes_read = file_read (file_object, buffer, size); 
-    //------------- finish critical section ----------------
-    lock_release (&rw_lock);
-
+    uint8_t *kbuf;
+
+    /* 다른 스레드가 close()해도 읽는 동안은 해제되지 않도록 참조를 잡아둔다.
+       file->pos는 file_read() 안에서 파일마다 있는 lock으로 보호된다. */
+    file_object = process_get_file (fd);
+    if (file_object == NULL)
+      return -1;
+    /* 유저 buffer에 복사하다 page fault가 나면 fault handler가 vm_lock을 잡고
+       eviction에서 rw_lock을 다시 잡을 수 있으므로, rw_lock을 잡은 동안에는
+       커널 buffer로만 읽고 유저 buffer로의 복사는 lock을 놓은 뒤에 한다. */
+    kbuf = palloc_get_page (0);
+    if (kbuf == NULL) {
+      put_file (file_object);
+      return -1;
+    }
+    while (size > 0) {
+      off_t chunk = size < PGSIZE ? size : PGSIZE;
+      off_t n;
+
+      /* 파일을 읽는 동안 다른 프로세스가 파일을 수정하지 못하도록 lock을 걸음.
+         읽기끼리는 buffer cache entry lock으로 충분하므로 동시에 진행할 수 있음 */
+      rwlock_acquire_read (&rw_lock);
+      //---------- start critical section -----------
+
+      /* 해당 파일에서 chunk크기 만큼 읽고 (혹은 EOF 읽는 지점까지) 
+         읽은 byte 수를 반환함. */
+      n = file_read (file_object, kbuf, chunk);
+      //------------- finish critical section ----------------
+      rwlock_release_read (&rw_lock);
+
+      memcpy ((uint8_t *) buffer + bytes_read, kbuf, n);
+      bytes_read += n;
+      size -= n;
+      if (n < chunk)
+        break;
+    }
+    palloc_free_page (kbuf);
+    put_file (file_object);
  }
 
   // 읽어온 byte 수를 리턴함
@@ -380,10 +573,14 @@ int filesize (int fd) {
     return -1;
   } else { 
 
+    int length;
+
     /* file_length() 내부적으로 
        file object->inode->inode_disk.length 를 
        참조하여 파일 사이즈를 가져옴 */
-    return file_length (file_object);
+    length = file_length (file_object);
+    put_file (file_object);
+    return length;
   }
   
 }
@@ -399,26 +596,30 @@ int filesize (int fd) {
 int open (const char *file) {
   
   struct file *file_object; 
+  int fd;
   // open-null testcase를 통과하기 위한 예외처리
   if (file == NULL) {
     exit(-1);
   } else {
     /* filesys_open() 으로 해당 파일이름과 경로에 해당하는 파일을 열어서 파일객체를 반환함
        이 과정에서 해당 파일이 없거나 권한에 문제가 있어 열지 못한다면 null을 반환함 */
-    lock_acquire (&rw_lock);
-    file_object = filesys_open (file);
-    lock_release (&rw_lock);
-  }
-  
-  /* 해당 파일이 문제가 있어 null을 반환 받았다면 -1리턴 */
-  if (file_object == NULL) {
-    return -1;
-  } else {
-    /* 정상적으로 파일 객체를 반환 받았으면
+    char *name = copy_in_string (file);
+
+    if (name == NULL)
+      return -1;
+    rwlock_acquire_write (&rw_lock);
+    file_object = filesys_open (name);
+    /* 해당 파일이 문제가 있어 null을 반환 받았다면 -1리턴
+       정상적으로 파일 객체를 반환 받았으면
        해당 FDT에 파일 객체 포인터를 추가하여 
-       해당 FD number를 리턴함*/
-    return process_add_file(file_object);
+       해당 FD number를 리턴함.
+       FDT는 같은 프로세스의 스레드들이 공유하므로 process_add_file()이
+       main 스레드의 fdt_lock을 잡고 추가함 */
+    fd = file_object == NULL ? -1 : process_add_file (file_object);
+    rwlock_release_write (&rw_lock);
+    palloc_free_page (name);
   }
+  return fd;
 }
 
 /* user mode에서도 process_wait를 사용할 수 있도록 시스템 콜에 추가함 */
@@ -440,7 +641,9 @@ struct vm_entry *check_address (void *addr)
   
   /* addr이 vm_entry에 존재하면 vm_entry를 반환하도록 코드 작성 */
   /* find_vme() 사용*/ 
+  lock_acquire (&thread_current ()->proc->vm_lock);
   vme = find_vme (addr);
+  lock_release (&thread_current ()->proc->vm_lock);
   if (!vme)
     return NULL;
   
@@ -469,12 +672,30 @@ void halt ()
   shutdown_power_off ();     
 }
 
-// 현재 돌아가는 프로세스를 종료시키는 시스템 콜 함수
+/* 현재 돌아가는 프로세스를 종료시키는 시스템 콜 함수
+   어느 스레드가 호출하든 프로세스 전체가 종료된다. 다른 스레드들은
+   유저 모드로 돌아가기 전에 process_check_exit()에서 종료되고,
+   main 스레드가 종료 메시지를 출력한다. */
 void exit (int status)
 {
   struct thread *current_thread = thread_current ();
-  current_thread->exit_status = status;
-  printf ("%s: exit(%d)\n", current_thread->name, status);
+  struct thread *proc = current_thread->proc;
+  enum intr_level old_level;
+  bool first;
+
+  old_level = intr_disable ();
+  first = !proc->exiting;
+  if (first) {
+    proc->exit_status = status;
+    proc->exiting = true;
+  }
+  intr_set_level (old_level);
+
+  /* futex나 process_wait() 등에서 잠든 다른 스레드들을 깨워서 종료될 수 있게 함 */
+  if (first && proc->uthread_cnt > 0)
+    process_wake_threads (proc);
+  if (current_thread == proc)
+    printf ("%s: exit(%d)\n", current_thread->name, proc->exit_status);
   thread_exit ();
 }
 
@@ -486,9 +707,14 @@ bool create (const char *file, unsigned initial_size)
   if (file == NULL) {
     exit (-1);
   } else {
-    lock_acquire (&rw_lock);
-    success = filesys_create (file, initial_size);
-    lock_release (&rw_lock);
+    char *name = copy_in_string (file);
+
+    if (name == NULL)
+      return false;
+    rwlock_acquire_write (&rw_lock);
+    success = filesys_create (name, initial_size);
+    rwlock_release_write (&rw_lock);
+    palloc_free_page (name);
     return success;
   }
 
@@ -498,9 +724,14 @@ bool create (const char *file, unsigned initial_size)
 bool remove (const char *file)
 {
   bool success;
-  lock_acquire (&rw_lock);
-  success = filesys_remove(file);
-  lock_release (&rw_lock);
+  char *name = copy_in_string (file);
+
+  if (name == NULL)
+    return false;
+  rwlock_acquire_write (&rw_lock);
+  success = filesys_remove(name);
+  rwlock_release_write (&rw_lock);
+  palloc_free_page (name);
   return success;
 }
 
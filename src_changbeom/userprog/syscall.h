@@ -6,7 +6,8 @@
 void munmap (int mapping);
 struct vm_entry *check_address (void *addr);
 void syscall_init (void);
-struct lock rw_lock;
+void exit (int status) NO_RETURN;
+struct rwlock rw_lock;
 
 typedef int pid_t;
 typedef int mapid_t;
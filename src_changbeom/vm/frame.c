@@ -83,10 +83,10 @@ void *try_to_free_pages (enum palloc_flags flags) {
     switch (victim_page->vme->type) {
       case VM_FILE :
         /* 일반 file인경우 swap partition에 swap out하는것보다 원래 파일에 wrtie-back 한다 */
-        lock_acquire (&rw_lock);
+        rwlock_acquire_write (&rw_lock);
         file_write_at (victim_page->vme->file, victim_page->kaddr,
                        victim_page->vme->read_bytes, victim_page->vme->offset);
-        lock_release (&rw_lock);
+        rwlock_release_write (&rw_lock);
         break;
       case VM_BIN :
         /* 실행파일은 프로세스 실행중에 write를 못한다. 
@@ -9,6 +9,21 @@
 
 extern struct lock lru_lock;
 
+struct kmem_cache *page_struct_cache;
+struct kmem_cache *vme_cache;
+struct kmem_cache *mmap_file_cache;
+
+/* page, vm_entry, mmap_file 구조체들의 cache를 만든다. */
+void vm_cache_init (void) {
+  page_struct_cache = kmem_cache_create ("page", sizeof (struct page), NULL);
+  vme_cache = kmem_cache_create ("vm_entry", sizeof (struct vm_entry), NULL);
+  mmap_file_cache = kmem_cache_create ("mmap_file", sizeof (struct mmap_file),
+                                       NULL);
+  if (page_struct_cache == NULL || vme_cache == NULL
+      || mmap_file_cache == NULL)
+    PANIC ("vm_cache_init: out of memory");
+}
+
 bool load_file (void *kaddr, struct vm_entry *vme) {
   /* Using file_read_at()*/
   /* file_read_at으로 물리페이지에 read_bytes만큼 데이터를 씀*/
@@ -61,8 +76,11 @@ bool delete_vme (struct hash *vm, struct vm_entry *vme) {
   return !!hash_delete (vm, &vme->elem);
 }
 
+/* 현재 프로세스에서 vaddr을 포함하는 가상 페이지의 vm_entry를 찾는다.
+   vm 해시테이블은 같은 프로세스의 스레드들이 공유하므로
+   호출하는 쪽에서 main 스레드의 vm_lock을 잡고 있어야 한다. */
 struct vm_entry *find_vme (void *vaddr) {
-  struct hash *vm = &thread_current ()->vm;
+  struct hash *vm = &thread_current ()->proc->vm;
   struct vm_entry vme;
 
   /*  pg_round_down()으로 vaddr의 페이지 번호를 얻음 */
@@ -146,12 +164,15 @@ void check_valid_string (const void *str, void *esp) {
 struct page *alloc_page (enum palloc_flags flags) {
   struct page *page = NULL;
   lock_acquire (&lru_lock);
-  page = (struct page*)malloc (sizeof (struct page));
+  page = kmem_cache_alloc (page_struct_cache);
   if (page == NULL) {
+    lock_release (&lru_lock);
     return NULL;
   }
   memset (page, 0x00, sizeof (struct page));
-  page->thread = thread_current ();
+  /* 유저 스레드는 main 스레드보다 먼저 종료될 수 있으므로
+     page의 주인은 pagedir을 가진 main 스레드로 한다. */
+  page->thread = thread_current ()->proc;
   page->kaddr = palloc_get_page (flags);
   /* 물리 페이지 할당에 실패하면 페이지 풀이 가득 찬것이므로
      victim page를 선정해 swap out을 시킨 후 page를 할당한다. */
@@ -163,10 +184,14 @@ struct page *alloc_page (enum palloc_flags flags) {
   return page;
 }
 
+/* kaddr에 해당하는 물리 페이지를 해제한다. do_munmap()처럼 lru_lock을
+   이미 잡은 채로 호출해도 된다. */
 void free_page (void *kaddr) {
   struct list_elem *e = NULL;
   struct page *page = NULL;
-  lock_acquire (&lru_lock);
+  bool locked = !lock_held_by_current_thread (&lru_lock);
+  if (locked)
+    lock_acquire (&lru_lock);
   /* lru_list를 순회하여 kaddr를 물리 페이지 주소로 같는 page구조체를 찾는다 */
   for (e = list_begin (&lru_list); e != list_end (&lru_list); e = list_next (e)) {
     page = list_entry (e, struct page, lru);
@@ -178,12 +203,13 @@ void free_page (void *kaddr) {
   if (page != NULL) {
     __free_page (page);
   }
-  lock_release (&lru_lock);
+  if (locked)
+    lock_release (&lru_lock);
 }
 
 void __free_page (struct page* page) {
   pagedir_clear_page (page->thread->pagedir, page->vme->vaddr);
   del_page_from_lru_list (page);
   palloc_free_page (page->kaddr);
-  free (page);
+  kmem_cache_free (page_struct_cache, page);
 }
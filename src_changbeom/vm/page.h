@@ -6,6 +6,7 @@
 #include "threads/thread.h"
 #include "filesys/file.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 
 #define VM_BIN  0
 #define VM_FILE 1
@@ -47,6 +48,13 @@ struct page  {
   struct list_elem lru;
 };
 
+/* struct page, vm_entry, mmap_file들의 cache. */
+extern struct kmem_cache *page_struct_cache;
+extern struct kmem_cache *vme_cache;
+extern struct kmem_cache *mmap_file_cache;
+
+void vm_cache_init (void);
+
 static bool vm_less_func (const struct hash_elem *a, const struct hash_elem *b); 
 static unsigned vm_hash_func (const struct hash_elem *e, void *aux);
 bool insert_vme (struct hash *vm, struct vm_entry *vme);
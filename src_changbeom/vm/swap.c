@@ -14,6 +14,10 @@ struct block *swap_block;
 void swap_init (void) {
   lock_init (&swap_lock);
   swap_bitmap = bitmap_create (SWAP_SIZE / PGSIZE);
+  /* swap이 거의 다 찼을 때 빈 slot을 빨리 찾도록 summary를 붙인다.
+     실패해도 scan이 느려질 뿐이다. */
+  if (swap_bitmap != NULL)
+    bitmap_add_summary (swap_bitmap);
   /* swap block 구조체를 가져온다 */
   swap_block = block_get_role (BLOCK_SWAP);
 }
@@ -26,12 +30,13 @@ size_t swap_out (void *kaddr) {
   swap_index = bitmap_scan_and_flip (swap_bitmap, 0, 1, false);
   /* 한 페이지에 8개의 block이 사용 되므로 block index는 8배가 됨 */
   sector_index = swap_index << 3;
-  /* sector_index로부터 8개 block에 페이지의 내용을 write함 */
-  lock_acquire (&rw_lock);
+  /* sector_index로부터 8개 block에 페이지의 내용을 write함.
+     swap 영역은 swap_lock으로 보호되므로 파일 시스템의 rw_lock은 잡지 않는다.
+     page fault 처리 중에 불리므로 rw_lock을 잡으면 read()/write()와
+     lock 순서가 꼬일 수 있다. */
   for (i = 0; i < SECTORS_PER_PAGE; i++) {
     block_write (swap_block, sector_index + i, kaddr + BLOCK_SECTOR_SIZE * i);
   }
-  lock_release (&rw_lock);
   lock_release (&swap_lock);
   return swap_index;
 }
@@ -40,12 +45,10 @@ void swap_in (size_t used_index, void *kaddr) {
   int i = 0;
   size_t sector_index = used_index << 3;
   lock_acquire (&swap_lock);
-  lock_acquire (&rw_lock);
   /* sector_index로부터 8개 block으로부터 페이지로 load함 */
   for (i = 0; i < SECTORS_PER_PAGE; i++)  {
     block_read (swap_block, sector_index + i, kaddr + BLOCK_SECTOR_SIZE * i);
   }
-  lock_release (&rw_lock);
   /* used index번째 8의 block묶음이 다른 페이지 아웃에ㅑ
      사용될 수 있도록 bitmap에 used_index bit을 reset함 */
   bitmap_set (swap_bitmap, used_index, false);